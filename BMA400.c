@@ -38,45 +38,125 @@
 
 #include "bma400.h"
 #include "spidrv.h"
-#include "udelay.h"
-#include "stdio.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "em_ldma.h"
+#include "gpiointerrupt.h"
+#include "sl_sleeptimer.h"
+#include "em_core.h"
+#include "sleep.h"
+#include "string.h"
+#include "stddef.h"
 /*
- * @brief Accel self test diff xyz data structure
+ * @brief Pending asynchronous FIFO read
  */
-struct selftest_delta_limit {
-	/* Accel X  data */
-	int32_t x;
+struct fifo_async_read {
+	/* FIFO structure being filled */
+	struct bma400_fifo_data *fifo;
 
-	/* Accel Y  data */
-	int32_t y;
+	/* User completion callback and its context */
+	bma400_fifo_cb_t callback;
+	void *cb_ctx;
 
-	/* Accel Z  data */
-	int32_t z;
+	/* Index of the first FIFO byte in the buffer */
+	uint16_t start_idx;
+
+	/* Bus transaction of the transfer */
+	struct bma400_spi_xfer xfer;
+
+	/* A transfer is in progress */
+	volatile uint8_t busy;
 };
 
+static struct fifo_async_read fifo_async;
+
+/* Owner of the bus during a continuous acquisition */
+static struct bma400_spi_xfer fifo_acq_xfer;
+
+/* SPI transactions queued or running on any bus */
+static volatile uint8_t spi_xfer_count;
+
+/* Sent by the scatter-gather segments without TX data */
+static const uint8_t spi_sg_tx_zero;
+
+/* Receives the bytes of the scatter-gather segments without RX data */
+static uint8_t spi_sg_rx_sink;
+
 /*
- * @brief This API is used to calculate the power of given
- * base value.
- *
- * @param[in] base : value of base
- * @param[in] resolution : resolution of the sensor
- *
- * @return : return the value of base^resolution
+ * @brief Trace ring, written from any context and drained from the
+ * application loop
+ */
+struct trace_ring {
+	/* Records, a slot is free while its event is BMA400_TRACE_NONE */
+	struct bma400_trace_rec rec[BMA400_TRACE_LEN];
+
+	/* Records reserved by the writers */
+	volatile uint32_t head;
+
+	/* Records drained */
+	volatile uint32_t tail;
+
+	/* Records lost while the ring was full */
+	volatile uint32_t dropped;
+};
+
+static struct trace_ring trace_ring;
+
+/* Clocked out by the TX DMA during a continuous acquisition */
+static uint8_t fifo_acq_tx_dummy;
+
+/* Watermark acquisitions by GPIO interrupt number */
+static struct bma400_fifo_wm_acq *fifo_wm_acq[BMA400_GPIO_INT_COUNT];
+
+/* Owner of the bus while the autonomous polling is armed */
+static struct bma400_spi_xfer dma_poll_xfer;
+
+/* Armed autonomous polling, a single one at a time */
+static struct bma400_dma_poll *dma_poll;
+
+/*
+ * @brief Destination of the unpacked FIFO frames, the axis values of frame
+ * n are stored n * stride bytes past x, y and z. These are byte pointers
+ * into the whole destination array, so stepping over an array of
+ * structures never goes past the member it was taken from
+ */
+struct accel_out {
+	uint8_t *x;
+	uint8_t *y;
+	uint8_t *z;
+
+	/* Distance between two frames in bytes */
+	uint16_t stride;
+};
+
+/*
+ * @brief Calibration of the unpacked FIFO frames in the form applied per
+ * sample, value = (raw * mult + add) >> BMA400_CALIB_SHIFT
+ */
+struct accel_calib {
+	int32_t mult[3];
+	int32_t add[3];
+};
+
+/*
+ * @brief mg per LSB of 12-bit accel data in Q7, indexed by range. 8-bit
+ * data carries 16 times the weight per LSB, i.e. the same table in Q3
  */
-static int32_t power(int16_t base, uint8_t resolution);
+static const uint16_t lsb_to_mg_q7[4] = { 125, 250, 500, 1000 };
 
 /*
- *  @brief This API converts lsb value of axes to mg for self-test
+ * @brief This API returns the number of fractional bits a raw sample
+ * of the given resolution has against 1 mg / 1 g
  *
- *  @param[in] accel_data_diff : Pointer variable used to pass accel difference
- *  values in g
- *  @param[out] accel_data_diff_mg : Pointer variable used to store accel
- *  difference values in mg
+ * @param[in] resolution : BMA400_8_BIT_RESOLUTION or BMA400_12_BIT_RESOLUTION
+ * @param[in] range      : Accel range, BMA400_2G_RANGE to BMA400_16G_RANGE
+ * @param[out] frac_bits : Fractional bits of the mg multiplier
  *
- *  @return None *
+ * @return Result of API execution status
+ * @retval zero -> Success / -ve value -> Error
  */
-static void convert_lsb_g(const struct selftest_delta_limit *accel_data_diff,
-		struct selftest_delta_limit *accel_data_diff_mg);
+static int8_t unit_conv_frac_bits(uint8_t resolution, uint8_t range,
+		uint8_t *frac_bits);
 
 /*
  * @brief This internal API is used to validate the device pointer for
@@ -118,6 +198,19 @@ static int8_t set_accel_conf(const struct bma400_acc_conf *accel_conf,
 static int8_t get_accel_data(uint8_t data_sel, struct bma400_sensor_data *accel,
 		const struct bma400_dev *dev);
 
+/*
+ * @brief This API decodes the accel data registers, and the sensor time
+ * registers following them if selected
+ *
+ * @param[in] data_array : ACC_X_LSB register onwards
+ * @param[in] data_sel   : Selection of sensor time
+ * @param[out] accel     : Structure instance to store the accel data
+ *
+ * @return Nothing
+ */
+static void unpack_sensor_data(const uint8_t *data_array, uint8_t data_sel,
+		struct bma400_sensor_data *accel);
+
 /*
  * @brief This API enables the auto-wakeup feature
  * of the sensor using a timeout value
@@ -471,20 +564,359 @@ static int8_t get_fifo_length(uint16_t *fifo_byte_cnt,
 static int8_t read_fifo(const struct bma400_fifo_data *fifo,
 		const struct bma400_dev *dev);
 
+/*
+ * @brief This API reads the FIFO length and configuration and computes the
+ * number of bytes to be read from the FIFO
+ *
+ * @param[in,out] fifo : Pointer to the fifo structure.
+ * @param[in] headroom : Bytes of the user buffer reserved ahead of the data
+ * @param[in] dev      : Structure instance of bma400_dev
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / +ve value -> Warning / -ve value -> Error
+ */
+static int8_t prepare_fifo_read(struct bma400_fifo_data *fifo,
+		uint16_t headroom, const struct bma400_dev *dev);
+
+/*
+ * @brief This API enables the FIFO read circuit if it is disabled
+ *
+ * @param[out] was_disabled : TRUE if the FIFO read had to be enabled
+ * @param[in] dev           : Structure instance of bma400_dev
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / +ve value -> Warning / -ve value -> Error
+ */
+static int8_t enable_fifo_read(uint8_t *was_disabled,
+		const struct bma400_dev *dev);
+
+/*
+ * @brief Bus transaction callback of the asynchronous FIFO read
+ *
+ * @param[in] rslt             : Result of the transaction
+ * @param[in] xfer             : Completed transaction
+ * @param[in] cb_ctx           : Unused
+ *
+ * @return Nothing
+ */
+static void fifo_async_done(int8_t rslt, struct bma400_spi_xfer *xfer,
+		void *cb_ctx);
+
+/*
+ * @brief DMADRV ping-pong callback of the continuous FIFO acquisition
+ *
+ * @param[in] channel          : DMA channel
+ * @param[in] sequence_no      : Number of completed buffers, from 1
+ * @param[in] user_param       : Acquisition context
+ *
+ * @return True to continue the acquisition, false to stop it
+ */
+static int fifo_acq_done(unsigned int channel, unsigned int sequence_no,
+		void *user_param);
+
+/*
+ * @brief This API stops the DMA transfers of a continuous FIFO acquisition
+ * and deselects the device at its own bit rate again
+ *
+ * @param[in] spi              : Structure instance of bma400_spi_dev
+ *
+ * @return Nothing
+ */
+static void fifo_acq_release(const struct bma400_spi_dev *spi);
+
+/*
+ * @brief GPIOINT callback of the FIFO watermark interrupt
+ *
+ * @param[in] int_no           : GPIO interrupt number
+ *
+ * @return Nothing
+ */
+static void fifo_wm_irq(uint8_t int_no);
+
+/*
+ * @brief GPIOINT callback of the data ready interrupt, releases one read
+ * of the autonomous polling
+ *
+ * @param[in] int_no           : GPIO interrupt number
+ *
+ * @return Nothing
+ */
+static void dma_poll_irq(uint8_t int_no);
+
+/*
+ * @brief This API builds the LDMA descriptor chains of the autonomous
+ * polling and starts them, then enables the data ready GPIO interrupt
+ *
+ * @param[in,out] poll         : Structure instance of bma400_dma_poll
+ * @param[in] spi              : Structure instance of bma400_spi_dev
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / -ve value -> Error
+ */
+static int8_t dma_poll_arm(struct bma400_dma_poll *poll,
+		const struct bma400_spi_dev *spi);
+
+/*
+ * @brief DMADRV callback of the RX chain of the autonomous polling, called
+ * once per received frame
+ *
+ * @param[in] channel          : DMA channel
+ * @param[in] sequence_no      : Number of received frames, from 1
+ * @param[in] user_param       : Polling context
+ *
+ * @return True to keep polling, false to stop
+ */
+static int dma_poll_done(unsigned int channel, unsigned int sequence_no,
+		void *user_param);
+
+/*
+ * @brief This API disables the data ready GPIO interrupt, stops the
+ * LDMA chains of the autonomous polling and gives the bus back
+ *
+ * @param[in,out] poll         : Structure instance of bma400_dma_poll
+ *
+ * @return Nothing
+ */
+static void dma_poll_release(struct bma400_dma_poll *poll);
+
+/*
+ * @brief This API selects an SPI device, setting the bus to its bit rate
+ * if another device used it last
+ *
+ * @param[in] spi              : Structure instance of bma400_spi_dev
+ *
+ * @return Nothing
+ */
+static void spi_select(const struct bma400_spi_dev *spi);
+
+/*
+ * @brief This API deselects an SPI device
+ *
+ * @param[in] spi              : Structure instance of bma400_spi_dev
+ *
+ * @return Nothing
+ */
+static void spi_deselect(const struct bma400_spi_dev *spi);
+
+/*
+ * @brief This API takes an idle bus with an empty queue for a transaction
+ * that is not queued, such as a blocking transfer
+ *
+ * @param[in] bus              : Structure instance of bma400_spi_bus
+ * @param[in] xfer             : Owner of the bus
+ *
+ * @return True if the bus was taken, false if it is in use
+ */
+static uint8_t spi_bus_claim(struct bma400_spi_bus *bus,
+		struct bma400_spi_xfer *xfer);
+
+/*
+ * @brief This API gives back a bus taken by spi_bus_claim() and starts the
+ * queued transactions
+ *
+ * @param[in] bus              : Structure instance of bma400_spi_bus
+ *
+ * @return Nothing
+ */
+static void spi_bus_release(struct bma400_spi_bus *bus);
+
+/*
+ * @brief This API starts the first queued transaction if the bus is idle
+ *
+ * @param[in] bus              : Structure instance of bma400_spi_bus
+ *
+ * @return Nothing
+ */
+static void spi_queue_next(struct bma400_spi_bus *bus);
+
+/*
+ * @brief This API hands the bus over to the next queued transaction and
+ * calls the completion callback of a finished one
+ *
+ * @param[in] bus              : Structure instance of bma400_spi_bus
+ * @param[in] xfer             : Finished transaction
+ * @param[in] rslt             : Result of the transaction
+ *
+ * @return Nothing
+ */
+static void spi_xfer_complete(struct bma400_spi_bus *bus,
+		struct bma400_spi_xfer *xfer, int8_t rslt);
+
+/*
+ * @brief SPIDRV completion callback of the queued transactions
+ *
+ * @param[in] handle           : SPIDRV handle, the first member of the bus
+ * @param[in] transfer_status  : Result of the transfer
+ * @param[in] items_transferred: Number of bytes transferred
+ *
+ * @return Nothing
+ */
+static void spi_queue_done(SPIDRV_Handle_t handle, Ecode_t transfer_status,
+		int items_transferred);
+
+/*
+ * @brief This API builds the LDMA descriptor chains of a scatter-gather
+ * transaction and starts them, the device being selected
+ *
+ * @param[in] bus              : Structure instance of bma400_spi_bus
+ * @param[in] xfer             : Scatter-gather transaction
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / -ve value -> Error
+ */
+static int8_t spi_sg_start(struct bma400_spi_bus *bus,
+		const struct bma400_spi_xfer *xfer);
+
+/*
+ * @brief DMADRV callback of the RX chain of a scatter-gather transaction,
+ * called once the last chip select frame has ended
+ *
+ * @param[in] channel          : DMA channel
+ * @param[in] sequence_no      : Number of completions
+ * @param[in] user_param       : Bus of the transaction
+ *
+ * @return Unused
+ */
+static int spi_sg_done(unsigned int channel, unsigned int sequence_no,
+		void *user_param);
+
+/*
+ * @brief Completion callback of the blocking transfers made while the bus
+ * is in use
+ *
+ * @param[in] rslt             : Result of the transaction
+ * @param[in] xfer             : Completed transaction
+ * @param[out] cb_ctx          : Result of the blocking transfer
+ *
+ * @return Nothing
+ */
+static void spi_sync_done(int8_t rslt, struct bma400_spi_xfer *xfer,
+		void *cb_ctx);
+
+/*
+ * @brief This API runs a blocking transfer in place, directly on an idle
+ * bus, otherwise queued at urgent priority. A busy bus is not waited for
+ * with interrupts masked or in an interrupt handler
+ *
+ * @param[in] spi              : Structure instance of bma400_spi_dev
+ * @param[in,out] buffer       : Bytes sent, and received if receive is set
+ * @param[in] length           : Number of bytes
+ * @param[in] receive          : Received bytes are stored in buffer
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / -ve value -> Error
+ */
+static int8_t spi_xfer_sync(const struct bma400_spi_dev *spi, uint8_t *buffer,
+		uint16_t length, uint8_t receive);
+
+/*
+ * @brief This API adds a record to the trace ring without locking, from any
+ * context. The record is dropped and counted if the ring is full.
+ *
+ * @param[in] event            : One of BMA400_TRACE_*
+ * @param[in] arg8             : First argument of the event
+ * @param[in] arg16            : Second argument of the event
+ * @param[in] arg32            : Third argument of the event
+ *
+ * @return Nothing
+ */
+static void trace(uint8_t event, uint8_t arg8, uint16_t arg16, uint32_t arg32);
+
+/*
+ * @brief This API returns the core clock cycle counter, enabling it on
+ * first use
+ *
+ * @return Cycle count
+ */
+static uint32_t cycle_count(void);
+
+/*
+ * @brief This API is the sleeptimer callback of delay()
+ *
+ * @param[in] handle           : Timer handle
+ * @param[in] data             : Expiry flag of the delay
+ *
+ * @return Nothing
+ */
+static void delay_timer_cb(sl_sleeptimer_timer_handle_t *handle, void *data);
+
+/*
+ * @brief This API is the sleeptimer callback of the asynchronous bring-up
+ *
+ * @param[in] handle           : Timer handle
+ * @param[in] data             : Structure instance of bma400_bringup
+ *
+ * @return Nothing
+ */
+static void bringup_timer_cb(sl_sleeptimer_timer_handle_t *handle,
+		void *data);
+
+/*
+ * @brief This API starts a bring-up operation and polls the sensor once,
+ * right away or after a settle time
+ *
+ * @param[in,out] bu           : Structure instance of bma400_bringup
+ * @param[in] state            : Operation, BMA400_BRINGUP_POWER_UP to
+ *                               BMA400_BRINGUP_POWER_MODE
+ * @param[in] settle_ms        : Time before the first poll, 0 polls at once
+ * @param[in] timeout_ms       : Longest time the sensor may take
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / +ve value -> Warning / -ve value -> Error
+ */
+static int8_t bringup_start(struct bma400_bringup *bu, uint8_t state,
+		uint8_t settle_ms, uint8_t timeout_ms);
+
+/*
+ * @brief This API checks whether the sensor finished the current bring-up
+ * operation, and arms the next poll if not
+ *
+ * @param[in,out] bu           : Structure instance of bma400_bringup
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / +ve value -> Warning / -ve value -> Error
+ */
+static int8_t bringup_poll(struct bma400_bringup *bu);
+
+/*
+ * @brief This API multiplies a sensor time difference by a Q32 rate
+ *
+ * @param[in] delta            : Sensor time difference, below 2^32
+ * @param[in] rate             : Rate in Q32
+ *
+ * @return delta * rate / 2^32
+ */
+static uint64_t mul_q32(uint64_t delta, uint64_t rate);
+
+/*
+ * @brief This API converts a sensor time to a sleeptimer tick with the
+ * current estimate, without checks
+ *
+ * @param[in] sync             : Structure instance of bma400_clock_sync
+ * @param[in] sensortime       : 64 bit sensor time
+ *
+ * @return Sleeptimer tick
+ */
+static uint64_t clock_sync_tick(const struct bma400_clock_sync *sync,
+		uint64_t sensortime);
+
 /*
  * @brief This API is used to unpack the accelerometer frames from the FIFO
  *
  * @param[in,out] fifo            : Pointer to the fifo structure.
- * @param[in,out] accel_data      : Structure instance to store the accel data
+ * @param[in] out                 : Destination of the accel data
  * @param[in,out] frame_count     : Number of frames requested by user as input
  *                                  Number of frames actually parsed as output
+ * @param[out] partial_idx        : Index of the header of a frame cut by the
+ *                                  end of the data, unchanged if there is
+ *                                  none. May be NULL.
  * @param[in] dev                 : Structure instance of bma400_dev
  *
  * @return Nothing
  */
 static void unpack_accel_frame(struct bma400_fifo_data *fifo,
-		struct bma400_sensor_data *accel_data, uint16_t *frame_count,
-		const struct bma400_dev *dev);
+		const struct accel_out *out, uint16_t *frame_count,
+		uint16_t *partial_idx, const struct bma400_dev *dev);
 
 /*
  * @brief This API is used to check for a frame availability in FIFO
@@ -501,6 +933,17 @@ static void check_frame_available(const struct bma400_fifo_data *fifo,
 		uint8_t *frame_available, uint8_t accel_width, uint8_t data_en,
 		uint16_t *data_index);
 
+/*
+ * @brief This API returns the number of bytes following the header of a
+ * FIFO frame
+ *
+ * @param[in] accel_width      : Variable to denote 12/8 bit accel data
+ * @param[in] data_en          : Frame header without the accel width bit
+ *
+ * @return Number of bytes, 0 for frames without data
+ */
+static uint8_t fifo_payload_len(uint8_t accel_width, uint8_t data_en);
+
 /*
  * @brief This API is used to unpack the accelerometer xyz data from the FIFO
  * and store it in the user defined buffer
@@ -517,6 +960,88 @@ static void unpack_accel(const struct bma400_fifo_data *fifo,
 		struct bma400_sensor_data *accel_data, uint16_t *data_index,
 		uint8_t accel_width, uint8_t frame_header);
 
+/*
+ * @brief This API unpacks a run of complete 12 bit XYZ frames from the FIFO.
+ * It stops at the first other header, partial frame or after max_frames
+ *
+ * @param[in] fifo             : Pointer to the fifo structure.
+ * @param[in] out              : Destination of the accel data
+ * @param[in] out_index        : Index of the first frame in out
+ * @param[in] max_frames       : Maximum number of frames to unpack
+ * @param[in,out] data_index   : Index of the currently parsed FIFO data
+ * @param[in] cal              : Calibration applied to each value
+ *
+ * @return Number of frames unpacked
+ */
+static uint16_t unpack_xyz12_run(const struct bma400_fifo_data *fifo,
+		const struct accel_out *out, uint16_t out_index, uint16_t max_frames,
+		uint16_t *data_index, const struct accel_calib *cal);
+
+/*
+ * @brief This API unpacks a run of complete 8 bit XYZ frames from the FIFO,
+ * scaled like 12 bit data. It stops at the first other header, partial
+ * frame or after max_frames
+ *
+ * @param[in] fifo             : Pointer to the fifo structure.
+ * @param[in] out              : Destination of the accel data
+ * @param[in] out_index        : Index of the first frame in out
+ * @param[in] max_frames       : Maximum number of frames to unpack
+ * @param[in,out] data_index   : Index of the currently parsed FIFO data
+ * @param[in] cal              : Calibration applied to each value
+ *
+ * @return Number of frames unpacked
+ */
+static uint16_t unpack_xyz8_run(const struct bma400_fifo_data *fifo,
+		const struct accel_out *out, uint16_t out_index, uint16_t max_frames,
+		uint16_t *data_index, const struct accel_calib *cal);
+
+/*
+ * @brief This API stores a frame taking the generic decode, calibrating
+ * the axes present in it
+ *
+ * @param[in] out              : Destination of the accel data
+ * @param[in] out_index        : Index of the frame in out
+ * @param[in] frame_data       : Decoded frame, missing axes at zero
+ * @param[in] frame_header     : Frame header without the accel width bit
+ * @param[in] cal              : Calibration applied to each value
+ *
+ * @return Nothing
+ */
+static void store_accel(const struct accel_out *out, uint16_t out_index,
+		const struct bma400_sensor_data *frame_data, uint8_t frame_header,
+		const struct accel_calib *cal);
+
+/*
+ * @brief This API expands the calibration of the device into the form
+ * applied per sample, unity when there is none
+ *
+ * @param[out] cal             : Calibration applied to each value
+ * @param[in] calib            : Calibration of the device, may be NULL
+ *
+ * @return Nothing
+ */
+static void accel_calib_load(struct accel_calib *cal,
+		const struct bma400_calib *calib);
+
+/*
+ * @brief This API computes the check of a calibration record
+ *
+ * @param[in] calib            : Calibration record
+ *
+ * @return Check over the fields before it
+ */
+static uint16_t calib_check(const struct bma400_calib *calib);
+
+/*
+ * @brief This API checks the coefficients of a calibration against the
+ * accepted gain error and offset
+ *
+ * @param[in] calib            : Calibration record
+ *
+ * @return TRUE when the coefficients are plausible
+ */
+static uint8_t calib_in_limits(const struct bma400_calib *calib);
+
 /*
  * @brief This API is used to parse and store the sensor time from the
  * FIFO data in the structure instance dev
@@ -536,15 +1061,15 @@ static void unpack_sensortime_frame(struct bma400_fifo_data *fifo,
  *                        for positive excitation
  * @param[in] accel_neg : Structure pointer to store accel data
  *                        for negative excitation
- *
- *@param[in] dev   : structure instance of bma400_dev
+ * @param[out] result   : Excursion of each axis and failed axes
  *
  * @return Result of API execution status
  * @retval zero -> Success  / -ve value -> Error / +ve value -> Self test fail
  */
 static int8_t validate_accel_self_test(
 		const struct bma400_sensor_data *accel_pos,
-		const struct bma400_sensor_data *accel_neg);
+		const struct bma400_sensor_data *accel_neg,
+		struct bma400_self_test_result *result);
 
 /*
  * @brief This API performs self test with positive excitation
@@ -582,66 +1107,537 @@ static int8_t negative_excited_accel(struct bma400_sensor_data *accel_neg,
  */
 static int8_t enable_self_test(const struct bma400_dev *dev);
 
-//SPIDRV_HandleData_t handleData;
-//SPIDRV_Handle_t handle = &handleData;
-
-uint8_t spi_read(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data,
-		uint16_t length) {
-	SPIDRV_HandleData_t handleData;
-	SPIDRV_Handle_t handle = &handleData;
-	uint8_t buffer[length + 1];
-	buffer[0] = reg_addr;
-	uint32_t errno = SPIDRV_MReceiveB(handle, &buffer, length + 1);
-	printf("read() full err:%X\n err code: %X\n", errno,(uint16_t)errno);
-	for (int i = 0; i < length; i++) {
-		reg_data[i] = buffer[i + 1];
-	}
-	return errno;
+/*
+ * @brief This API is the sleeptimer callback of the asynchronous self-test
+ *
+ * @param[in] handle           : Timer handle
+ * @param[in] data             : Structure instance of bma400_self_test
+ *
+ * @return Nothing
+ */
+static void self_test_timer_cb(sl_sleeptimer_timer_handle_t *handle,
+		void *data);
+
+/*
+ * @brief This API arms the timer of the next asynchronous self-test step
+ *
+ * @param[in,out] st           : Structure instance of bma400_self_test
+ * @param[in] ms               : Time until the step
+ *
+ * @return Result of API execution status
+ * @retval +ve value -> BMA400_W_IN_PROGRESS / -ve value -> Error
+ */
+static int8_t self_test_wait(struct bma400_self_test *st, uint8_t ms);
+
+/*
+ * @brief This API runs the due step of the asynchronous self-test, and
+ * restores the configuration once it ends
+ *
+ * @param[in,out] st           : Structure instance of bma400_self_test
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / +ve value -> Warning / -ve value -> Error
+ */
+static int8_t self_test_step(struct bma400_self_test *st);
+
+/*
+ * @brief This API disables the excitation and writes the saved accel
+ * configuration back in a single transaction
+ *
+ * @param[in] st               : Structure instance of bma400_self_test
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / -ve value -> Error
+ */
+static int8_t self_test_restore(const struct bma400_self_test *st);
+
+/*
+ * @brief This API writes interleaved register address/data pairs to the
+ * sensor within a single chip-select frame
+ *
+ * @param[in] pairs   : Buffer of address/data pairs
+ * @param[in] n_regs  : Number of pairs in the buffer
+ * @param[in] dev     : Structure instance of bma400_dev
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / +ve value -> Warning / -ve value -> Error
+ */
+static int8_t write_reg_pairs(uint8_t *pairs, uint8_t n_regs,
+		const struct bma400_dev *dev);
+
+/*
+ * @brief This API checks whether a register is held in the shadow and its
+ * value can be served without reading the sensor
+ *
+ * @param[in] reg_addr : Register address
+ * @param[in] shadow   : Register shadow of the device
+ *
+ * @return TRUE if the shadowed value is usable, FALSE otherwise
+ */
+static uint8_t shadow_reg_valid(uint8_t reg_addr,
+		const struct bma400_reg_shadow *shadow);
+
+/*
+ * @brief This API serves a register read from the shadow when every
+ * requested register is validly shadowed
+ *
+ * @param[in] reg_addr  : Register address of the first byte
+ * @param[out] reg_data : Buffer to store the shadowed values
+ * @param[in] len       : No of bytes to be read
+ * @param[in] dev       : Structure instance of bma400_dev
+ *
+ * @return TRUE if the read was served from the shadow, FALSE otherwise
+ */
+static uint8_t shadow_read(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
+		const struct bma400_dev *dev);
+
+/*
+ * @brief This API stores register values read from or written to the sensor
+ * in the shadow
+ *
+ * @param[in] reg_addr : Register address of the first byte
+ * @param[in] reg_data : Register values
+ * @param[in] len      : No of bytes
+ * @param[in] dev      : Structure instance of bma400_dev
+ *
+ * @return Nothing
+ */
+static void shadow_update(uint8_t reg_addr, const uint8_t *reg_data,
+		uint16_t len, const struct bma400_dev *dev);
+
+/*
+ * @brief This API compares register values read from the sensor against the
+ * valid shadowed values and counts the differences
+ *
+ * @param[in] reg_addr : Register address of the first byte
+ * @param[in] reg_data : Register values read from the sensor
+ * @param[in] len      : No of bytes
+ * @param[in] dev      : Structure instance of bma400_dev
+ *
+ * @return Number of registers whose shadowed value differs
+ */
+static uint16_t shadow_check(uint8_t reg_addr, const uint8_t *reg_data,
+		uint16_t len, const struct bma400_dev *dev);
+
+/*
+ * @brief This API packs the accel configurations into the register values
+ * of ACCEL_CONFIG_0 to ACCEL_CONFIG_2
+ *
+ * @param[in,out] data_array : Current register values as input,
+ *                             updated register values as output
+ * @param[in] accel_conf     : Structure instance with accel configurations
+ *
+ * @return Nothing
+ */
+static void pack_accel_conf(uint8_t *data_array,
+		const struct bma400_acc_conf *accel_conf);
+
+/*
+ * @brief This API packs the tap settings into the register values
+ * of TAP_CONFIG and TAP_CONFIG1
+ *
+ * @param[in,out] reg_data : Current register values as input,
+ *                           updated register values as output
+ * @param[in] tap_set      : Structure instance of tap configurations
+ *
+ * @return Nothing
+ */
+static void pack_tap_conf(uint8_t *reg_data,
+		const struct bma400_tap_conf *tap_set);
+
+/*
+ * @brief This API packs the activity change settings into the register
+ * values of ACT_CH_CONFIG_0 and ACT_CH_CONFIG_1
+ *
+ * @param[out] data_array : Register values
+ * @param[in] act_ch_set  : Structure instance of activity change
+ *                          configurations
+ *
+ * @return Nothing
+ */
+static void pack_activity_change_conf(uint8_t *data_array,
+		const struct bma400_act_ch_conf *act_ch_set);
+
+/*
+ * @brief This API packs the generic interrupt settings into the register
+ * values of GEN1/GEN2 INT_CONFIG
+ *
+ * @param[out] data_array : Register values
+ * @param[in] gen_int_set : Structure instance of generic interrupt
+ *                          configurations
+ *
+ * @return Number of registers set, including the reference values only
+ * for manual reference update
+ */
+static uint8_t pack_gen_int(uint8_t *data_array,
+		const struct bma400_gen_int_conf *gen_int_set);
+
+/*
+ * @brief This API packs the orientation interrupt settings into the
+ * register values of ORIENTCH_CONFIG
+ *
+ * @param[out] data_array : Register values
+ * @param[in] orient_conf : Structure instance of orient interrupt
+ *                          configurations
+ *
+ * @return Number of registers set, including the reference values only
+ * for manual reference update
+ */
+static uint8_t pack_orient_int(uint8_t *data_array,
+		const struct bma400_orient_int_conf *orient_conf);
+
+/*
+ * @brief This API packs the interrupt pin configuration into the
+ * value of INT12_IO_CTRL
+ *
+ * @param[in,out] reg_data : Current register value as input,
+ *                           updated register value as output
+ * @param[in] int_conf     : Interrupt pin configuration
+ *
+ * @return Nothing
+ */
+static void pack_int_pin_conf(uint8_t *reg_data,
+		struct bma400_int_pin_conf int_conf);
+
+/*
+ * @brief This API packs the FIFO configurations into the register values
+ * of FIFO_CONFIG_0 to FIFO_CONFIG_2
+ *
+ * @param[in,out] data_array : Current register values as input,
+ *                             updated register values as output
+ * @param[in] fifo_conf      : Structure instance containing the FIFO
+ *                             configurations
+ *
+ * @return Number of registers to be written, 3 if the water-mark changed
+ * and 1 otherwise
+ */
+static uint8_t pack_fifo_conf(uint8_t *data_array,
+		const struct bma400_fifo_conf *fifo_conf);
+
+/*
+ * @brief This API packs a list of sensor and device configurations into a
+ * configuration image of the registers from BMA400_CONF_IMAGE_START_ADDR
+ *
+ * @param[in,out] image    : Current configuration image as input,
+ *                           target configuration image as output
+ * @param[in] sensor_conf  : Sensor configurations, may be NULL
+ * @param[in] n_sensor     : Number of sensor configurations
+ * @param[in] device_conf  : Device configurations, may be NULL
+ * @param[in] n_device     : Number of device configurations
+ *
+ * @return Result of API execution status
+ * @retval zero -> Success / +ve value -> Warning / -ve value -> Error
+ */
+static int8_t pack_conf_image(uint8_t *image,
+		const struct bma400_sensor_conf *sensor_conf, uint16_t n_sensor,
+		const struct bma400_device_conf *device_conf, uint8_t n_device);
+
+/*
+ * @brief This API fills a configuration image with the reset values of
+ * the registers
+ *
+ * @param[out] image : Configuration image of BMA400_CONF_IMAGE_LEN bytes
+ *
+ * @return Nothing
+ */
+static void reset_conf_image(uint8_t *image);
+
+int8_t bma400_spi_bus_init(struct bma400_spi_bus *bus,
+		const SPIDRV_Init_t *init) {
+	int8_t rslt = BMA400_OK;
+	SPIDRV_Init_t bus_init;
+
+	if ((bus != NULL) && (init != NULL)) {
+		/* Each device on the bus drives its own chip select */
+		bus_init = *init;
+		bus_init.csControl = spidrvCsControlApplication;
+		bus->active = NULL;
+		bus->current = NULL;
+		bus->queue = NULL;
+		if (SPIDRV_Init(&bus->handle, &bus_init) != ECODE_EMDRV_SPIDRV_OK) {
+			rslt = BMA400_E_COM_FAIL;
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_spi_dev_init(struct bma400_spi_dev *spi,
+		struct bma400_spi_bus *bus, uint8_t cs_port, uint8_t cs_pin,
+		uint32_t bit_rate, struct bma400_dev *dev) {
+	int8_t rslt = BMA400_OK;
+
+	if ((spi != NULL) && (bus != NULL)) {
+		spi->bus = bus;
+		spi->cs_port = cs_port;
+		spi->cs_pin = cs_pin;
+		spi->bit_rate = bit_rate;
+		if ((bit_rate == 0) || (bit_rate > BMA400_SPI_MAX_BIT_RATE)) {
+			spi->bit_rate = BMA400_SPI_MAX_BIT_RATE;
+		}
+
+		/* Deselected until the first transfer */
+		GPIO_PinModeSet((GPIO_Port_TypeDef) cs_port, cs_pin, gpioModePushPull,
+				1);
+
+		/* Other devices sharing the bus are only reached through
+		 * bma400_spi_submit()
+		 */
+		if (dev != NULL) {
+			dev->intf = BMA400_SPI_INTF;
+			dev->intf_ptr = spi;
+			dev->read = spi_read;
+			dev->write = spi_write;
+			dev->delay_ms = delay;
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t spi_read(void *intf_ptr, uint8_t dev_id, uint8_t reg_addr,
+		uint8_t *reg_data, uint16_t length) {
+	uint8_t *buffer = &reg_data[-1];
+	uint32_t start = cycle_count();
+	int8_t rslt;
+
+	(void) dev_id;
+
+	/* Full duplex in place: each byte is sent before its slot is
+	 * received, the address from the byte in front of reg_data
+	 */
+	buffer[0] = reg_addr;
+	rslt = spi_xfer_sync((const struct bma400_spi_dev *) intf_ptr, buffer,
+			length + 1, TRUE);
+	if (rslt == BMA400_OK) {
+		trace(BMA400_TRACE_SPI_READ, reg_addr, length, cycle_count() - start);
+	} else {
+		trace(BMA400_TRACE_SPI_ERROR, reg_addr, length, (uint8_t) rslt);
+	}
+
+	return rslt;
 }
 
-uint8_t spi_write(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data,
-		uint16_t length) {
-	SPIDRV_HandleData_t handleData;
-	SPIDRV_Handle_t handle = &handleData;
-	uint8_t buffer[length + 1];
+int8_t spi_write(void *intf_ptr, uint8_t dev_id, uint8_t reg_addr,
+		uint8_t *reg_data, uint16_t length) {
+	uint8_t *buffer = &reg_data[-1];
+	uint32_t start = cycle_count();
+	int8_t rslt;
+
+	(void) dev_id;
+
+	/* Sent in place, the address from the byte in front of reg_data */
 	buffer[0] = reg_addr;
-	for (int i = 0; i < length; i++) {
-		reg_data[i] = buffer[i + 1];
+	rslt = spi_xfer_sync((const struct bma400_spi_dev *) intf_ptr, buffer,
+			length + 1, FALSE);
+	if (rslt == BMA400_OK) {
+		trace(BMA400_TRACE_SPI_WRITE, reg_addr, length, cycle_count() - start);
+	} else {
+		trace(BMA400_TRACE_SPI_ERROR, reg_addr, length, (uint8_t) rslt);
+	}
+
+	return rslt;
+}
+
+int8_t bma400_spi_submit(struct bma400_spi_xfer *xfer) {
+	int8_t rslt = BMA400_OK;
+	struct bma400_spi_xfer *volatile *link;
+	const struct bma400_spi_seg *seg;
+	uint8_t idx;
+	CORE_DECLARE_IRQ_STATE;
+
+	if ((xfer != NULL) && (xfer->spi != NULL) && (xfer->n_segs != 0)) {
+		if (xfer->segs == NULL) {
+			rslt = BMA400_E_NULL_PTR;
+		} else if (xfer->n_segs > BMA400_SPI_SG_MAX_SEGS) {
+			rslt = BMA400_E_INVALID_CONFIG;
+		}
+		for (idx = 0; (rslt == BMA400_OK) && (idx < xfer->n_segs); idx++) {
+			seg = &xfer->segs[idx];
+			if ((seg->length == 0) || (seg->length > DMADRV_MAX_XFER_COUNT)) {
+				rslt = BMA400_E_INVALID_CONFIG;
+			}
+		}
+	} else if ((xfer != NULL) && (xfer->spi != NULL)
+			&& ((xfer->tx_data != NULL) || (xfer->rx_data != NULL))) {
+		if ((xfer->length == 0) || (xfer->length > DMADRV_MAX_XFER_COUNT)) {
+			rslt = BMA400_E_INVALID_CONFIG;
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+	if (rslt == BMA400_OK) {
+		CORE_ENTER_ATOMIC();
+		if (xfer->busy) {
+			rslt = BMA400_E_BUSY;
+		} else {
+			/* Behind the transactions of the same or a higher
+			 * priority
+			 */
+			link = &xfer->spi->bus->queue;
+			while ((*link != NULL) && ((*link)->priority >= xfer->priority)) {
+				link = &(*link)->next;
+			}
+			xfer->next = *link;
+			*link = xfer;
+			xfer->busy = TRUE;
+			spi_xfer_count++;
+		}
+		CORE_EXIT_ATOMIC();
+	}
+	if (rslt == BMA400_OK) {
+		spi_queue_next(xfer->spi->bus);
+	}
+
+	return rslt;
+}
+
+int8_t bma400_spi_cancel(struct bma400_spi_xfer *xfer) {
+	int8_t rslt = BMA400_OK;
+	struct bma400_spi_xfer *volatile *link;
+	CORE_DECLARE_IRQ_STATE;
+
+	if ((xfer != NULL) && (xfer->spi != NULL)) {
+		CORE_ENTER_ATOMIC();
+		if (xfer->busy) {
+			link = &xfer->spi->bus->queue;
+			while ((*link != NULL) && (*link != xfer)) {
+				link = &(*link)->next;
+			}
+			if (*link == xfer) {
+				*link = xfer->next;
+				xfer->busy = FALSE;
+				spi_xfer_count--;
+			} else {
+				/* Already on the bus, it completes normally */
+				rslt = BMA400_E_BUSY;
+			}
+		}
+		CORE_EXIT_ATOMIC();
+	} else {
+		rslt = BMA400_E_NULL_PTR;
 	}
-	uint32_t errno = SPIDRV_MTransmitB(handle, buffer, length + 1);
-	printf("write() full err:%X\n err code: %X\n", errno,(uint16_t)errno);
-	return errno;
+
+	return rslt;
 }
 
 void delay(uint32_t ms) {
-	UDELAY_Delay(ms * 1000);
+	sl_sleeptimer_timer_handle_t timer;
+	volatile uint8_t expired = FALSE;
+	uint32_t ticks = 0;
+	uint8_t em2_blocked = FALSE;
+	CORE_DECLARE_IRQ_STATE;
+
+	if (ms == 0) {
+		return;
+	}
+
+	/* A tick more, as the current tick is already partly over */
+	if (CORE_IrqIsBlocked(RTCC_IRQn)
+			|| (sl_sleeptimer_ms32_to_tick(ms, &ticks) != SL_STATUS_OK)
+			|| (sl_sleeptimer_start_timer(&timer, ticks + 1, delay_timer_cb,
+					(void *) &expired, 0, 0) != SL_STATUS_OK)) {
+		/* Nothing could wake the core up, so the wait spins */
+		for (; ms > 0; ms--) {
+			delay_us(1000);
+		}
+		return;
+	}
+
+	/* The sleeptimer stops in EM3 */
+	SLEEP_SleepBlockBegin(sleepEM3);
+	CORE_ENTER_CRITICAL();
+	while (!expired) {
+		/* The USART and the DMA of SPI transactions stop in EM2 */
+		if ((spi_xfer_count != 0) && (em2_blocked == FALSE)) {
+			SLEEP_SleepBlockBegin(sleepEM2);
+			em2_blocked = TRUE;
+		}
+
+		/* Entered with interrupts masked, any pending one wakes the
+		 * core up and runs once they are unmasked
+		 */
+		(void) SLEEP_Sleep();
+		CORE_EXIT_CRITICAL();
+		CORE_ENTER_CRITICAL();
+	}
+	CORE_EXIT_CRITICAL();
+	if (em2_blocked) {
+		SLEEP_SleepBlockEnd(sleepEM2);
+	}
+	SLEEP_SleepBlockEnd(sleepEM3);
+}
+
+void delay_us(uint32_t us) {
+	uint32_t start = cycle_count();
+	uint32_t cycles;
+
+	cycles = (SystemCoreClockGet() / 1000000) * us;
+	while ((DWT->CYCCNT - start) < cycles) {
+	}
 }
 
 void print_rslt(int8_t rslt) {
-	switch (rslt) {
-	case BMA400_OK:
+	/* Recorded rather than printed, the text is restored on the host by
+	 * bma400_trace.py
+	 */
+	if (rslt != BMA400_OK) {
+		trace(BMA400_TRACE_RSLT, (uint8_t) rslt, 0, 0);
+	}
+}
 
-		/* Do nothing */
-		break;
-	case BMA400_E_NULL_PTR:
-		printf("Error [%d] : Null pointer\r\n", rslt);
-		break;
-	case BMA400_E_COM_FAIL:
-		printf("Error [%d] : Communication failure\r\n", rslt);
-		break;
-	case BMA400_E_DEV_NOT_FOUND:
-		printf("Error [%d] : Device not found\r\n", rslt);
-		break;
-	case BMA400_E_INVALID_CONFIG:
-		printf("Error [%d] : Invalid configuration\r\n", rslt);
-		break;
-	case BMA400_W_SELF_TEST_FAIL:
-		printf("Warning [%d] : Self test failed\r\n", rslt);
-		break;
-	default:
-		printf("Error [%d] : Unknown error code\r\n", rslt);
-		break;
+int8_t bma400_trace_drain(bma400_trace_write_t write, void *ctx,
+		uint16_t *n_recs) {
+	int8_t rslt = BMA400_OK;
+	struct bma400_trace_rec *slot;
+	struct bma400_trace_rec rec;
+	uint32_t tail;
+	uint32_t dropped;
+	uint16_t count = 0;
+
+	if ((write != NULL) && (n_recs != NULL)) {
+		tail = trace_ring.tail;
+		while (tail != trace_ring.head) {
+			slot = &trace_ring.rec[tail & (BMA400_TRACE_LEN - 1)];
+			if (slot->event == BMA400_TRACE_NONE) {
+				/* Reserved by a writer that was interrupted */
+				break;
+			}
+			__DMB();
+			rec = *slot;
+
+			/* The slot is given back before the slow output */
+			slot->event = BMA400_TRACE_NONE;
+			__DMB();
+			tail++;
+			trace_ring.tail = tail;
+			write((const uint8_t *) &rec, sizeof(rec), ctx);
+			count++;
+		}
+
+		/* The drops are reported after the records they followed */
+		do {
+			dropped = __LDREXW(&trace_ring.dropped);
+		} while (__STREXW(0, &trace_ring.dropped) != 0);
+		if (dropped != 0) {
+			rec.timestamp = sl_sleeptimer_get_tick_count();
+			rec.arg32 = dropped;
+			rec.arg16 = 0;
+			rec.arg8 = 0;
+			rec.event = BMA400_TRACE_DROPPED;
+			write((const uint8_t *) &rec, sizeof(rec), ctx);
+			count++;
+		}
+		*n_recs = count;
+	} else {
+		rslt = BMA400_E_NULL_PTR;
 	}
+
+	return rslt;
 }
 
 int8_t bma400_init(struct bma400_dev *dev) {
@@ -690,7 +1686,9 @@ int8_t bma400_init(struct bma400_dev *dev) {
 int8_t bma400_set_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
-	uint8_t count;
+	uint8_t count = 0;
+	uint8_t chunk;
+	struct bma400_reg_batch batch;
 
 	/* Check for null pointer in the device structure */
 	rslt = null_ptr_check(dev);
@@ -702,23 +1700,49 @@ int8_t bma400_set_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
 		/* SPI write requires to set The MSB of reg_addr as 0
 		 * but in default the MSB is always 0
 		 */
-		if (len == 1) {
-			rslt = spi_write(dev->dev_id, reg_addr, reg_data, len);
-			if (rslt != BMA400_OK) {
-				/* Failure case */
-				rslt = BMA400_E_COM_FAIL;
+
+		/* Burst write is not allowed, but address/data pairs may
+		 * follow each other within one chip-select frame. Thus
+		 * multiple bytes are packed into batches of pairs
+		 */
+		while ((rslt == BMA400_OK) && (count < len)) {
+			chunk = len - count;
+			if (chunk > BMA400_REG_BATCH_MAX_REGS) {
+				chunk = BMA400_REG_BATCH_MAX_REGS;
 			}
+			batch.n_regs = 0;
+			rslt = bma400_batch_add_regs(reg_addr + count, &reg_data[count],
+					chunk, &batch);
+			if (rslt == BMA400_OK) {
+				rslt = write_reg_pairs(batch.pairs, batch.n_regs, dev);
+			}
+			count += chunk;
 		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
 
-		/* Burst write is not allowed thus we split burst case write
-		 * into single byte writes Thus user can write multiple bytes
-		 * with ease
-		 */
-		if (len > 1) {
+	return rslt;
+}
+
+int8_t bma400_batch_add_regs(uint8_t reg_addr, const uint8_t *reg_data,
+		uint8_t len, struct bma400_reg_batch *batch) {
+	int8_t rslt = BMA400_OK;
+	uint8_t count;
+	uint8_t idx;
+
+	if ((batch != NULL) && (reg_data != NULL)) {
+		if ((batch->n_regs + len) <= BMA400_REG_BATCH_MAX_REGS) {
 			for (count = 0; count < len; count++) {
-				rslt = spi_write(dev->dev_id, reg_addr, &reg_data[count], 1);
-				reg_addr++;
+				idx = (uint8_t) (2 * batch->n_regs);
+				batch->pairs[idx] = (uint8_t) (reg_addr + count)
+						& BMA400_SPI_WR_MASK;
+				batch->pairs[idx + 1] = reg_data[count];
+				batch->n_regs++;
 			}
+		} else {
+			/* Batch cannot hold the requested registers */
+			rslt = BMA400_E_INVALID_CONFIG;
 		}
 	} else {
 		rslt = BMA400_E_NULL_PTR;
@@ -727,37 +1751,24 @@ int8_t bma400_set_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
 	return rslt;
 }
 
-int8_t bma400_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
-		const struct bma400_dev *dev) {
+int8_t bma400_batch_write(struct bma400_reg_batch *batch,
+		uint16_t *saved_xfers, const struct bma400_dev *dev) {
 	int8_t rslt;
-	uint16_t index;
-	uint16_t temp_len = len + dev->dummy_byte;
-	uint8_t temp_buff[temp_len];
 
 	/* Check for null pointer in the device structure */
 	rslt = null_ptr_check(dev);
 
 	/* Proceed if null check is fine */
-	if ((rslt == BMA400_OK) && (reg_data != NULL)) {
-		if (dev->intf != BMA400_I2C_INTF) {
-			/* If interface selected is SPI */
-			reg_addr = reg_addr | BMA400_SPI_RD_MASK;
+	if ((rslt == BMA400_OK) && (batch != NULL)) {
+		if (batch->n_regs > 0) {
+			rslt = write_reg_pairs(batch->pairs, batch->n_regs, dev);
 		}
-
-		/* Read the data from the reg_addr */
-		rslt = spi_read(dev->dev_id, reg_addr, temp_buff, temp_len);
 		if (rslt == BMA400_OK) {
-			for (index = 0; index < len; index++) {
-				/* Parse the data read and store in "reg_data"
-				 * buffer so that the dummy byte is removed
-				 * and user will get only valid data
-				 */
-				reg_data[index] = temp_buff[index + dev->dummy_byte];
+			/* One transaction replaces one write per register */
+			if (saved_xfers != NULL) {
+				*saved_xfers = (batch->n_regs > 0) ? (batch->n_regs - 1) : 0;
 			}
-		}
-		if (rslt != BMA400_OK) {
-			/* Failure case */
-			rslt = BMA400_E_COM_FAIL;
+			batch->n_regs = 0;
 		}
 	} else {
 		rslt = BMA400_E_NULL_PTR;
@@ -766,6 +1777,150 @@ int8_t bma400_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
 	return rslt;
 }
 
+int8_t bma400_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint16_t index;
+	uint8_t cached = FALSE;
+	uint8_t temp_buff[BMA400_REG_READ_MAX_LEN + BMA400_READ_HEADROOM];
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (reg_data != NULL)) {
+#ifndef BMA400_SHADOW_DEBUG
+		/* Registers known from the shadow need no bus access */
+		cached = shadow_read(reg_addr, reg_data, len, dev);
+#endif
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	if ((rslt == BMA400_OK) && (cached == FALSE)) {
+		if (len > BMA400_REG_READ_MAX_LEN) {
+			/* Longer reads use bma400_get_regs_inplace */
+			rslt = BMA400_E_INVALID_CONFIG;
+		} else {
+			/* Read the data from the reg_addr */
+			rslt = bma400_get_regs_inplace(reg_addr, temp_buff, len, dev);
+		}
+		if (rslt == BMA400_OK) {
+			for (index = 0; index < len; index++) {
+				/* Parse the data read and store in "reg_data"
+				 * buffer so that the address and dummy bytes
+				 * are removed and user will get only valid data
+				 */
+				reg_data[index] = temp_buff[index + 1 + dev->dummy_byte];
+			}
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_get_regs_inplace(uint8_t reg_addr, uint8_t *buffer, uint16_t len,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t *reg_data;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (buffer != NULL)) {
+		buffer[0] = reg_addr;
+		if (dev->intf != BMA400_I2C_INTF) {
+			/* If interface selected is SPI */
+			buffer[0] = reg_addr | BMA400_SPI_RD_MASK;
+		}
+
+		/* Read the data from the reg_addr, behind the address
+		 * and dummy bytes
+		 */
+		rslt = dev->read(dev->intf_ptr, dev->dev_id, buffer[0], &buffer[1],
+				len + dev->dummy_byte);
+		if (rslt == BMA400_OK) {
+			reg_data = &buffer[1 + dev->dummy_byte];
+#ifdef BMA400_SHADOW_DEBUG
+			/* Every read is checked against the shadow */
+			if (dev->shadow != NULL) {
+				dev->shadow->mismatch_cnt += shadow_check(reg_addr, reg_data,
+						len, dev);
+			}
+#endif
+			shadow_update(reg_addr, reg_data, len, dev);
+		} else {
+			/* Failure case */
+			rslt = BMA400_E_COM_FAIL;
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_shadow_invalidate(const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t idx;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (dev->shadow != NULL)) {
+		for (idx = 0; idx < sizeof(dev->shadow->valid); idx++) {
+			dev->shadow->valid[idx] = 0;
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_shadow_sync(const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t data_array[BMA400_SHADOW_LEN + BMA400_READ_HEADROOM];
+
+	/* Drop the current content, the following read refills it */
+	rslt = bma400_shadow_invalidate(dev);
+	if ((rslt == BMA400_OK) && (dev->shadow != NULL)) {
+		rslt = bma400_get_regs_inplace(BMA400_SHADOW_START_ADDR, data_array,
+				BMA400_SHADOW_LEN, dev);
+	}
+
+	return rslt;
+}
+
+int8_t bma400_shadow_verify(const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint16_t mismatch;
+	uint8_t data_array[BMA400_SHADOW_LEN + BMA400_READ_HEADROOM];
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (dev->shadow != NULL)) {
+		/* Read without refreshing the shadow */
+		rslt = dev->read(dev->intf_ptr, dev->dev_id,
+				BMA400_SHADOW_START_ADDR | BMA400_SPI_RD_MASK, &data_array[1],
+				BMA400_SHADOW_LEN + dev->dummy_byte);
+		if (rslt == BMA400_OK) {
+			mismatch = shadow_check(BMA400_SHADOW_START_ADDR,
+					&data_array[1 + dev->dummy_byte], BMA400_SHADOW_LEN, dev);
+			dev->shadow->mismatch_cnt += mismatch;
+			if (mismatch != 0) {
+				rslt = BMA400_W_SHADOW_MISMATCH;
+			}
+		} else {
+			rslt = BMA400_E_COM_FAIL;
+		}
+	}
+
+	return rslt;
+}
+
 int8_t bma400_soft_reset(const struct bma400_dev *dev)
 {
     int8_t rslt;
@@ -779,6 +1934,9 @@ int8_t bma400_soft_reset(const struct bma400_dev *dev)
         rslt = bma400_set_regs(BMA400_COMMAND_REG_ADDR, &data, 1, dev);
         //delay(BMA400_SOFT_RESET_delay);
         delay(10);
+
+        /* Registers are back to their default values */
+        (void) bma400_shadow_invalidate(dev);
         if ((rslt == BMA400_OK) && (dev->intf == BMA400_SPI_INTF))
         {
             /* Dummy read of 0x7F register to enable SPI Interface
@@ -819,6 +1977,146 @@ int8_t bma400_set_power_mode(uint8_t power_mode, const struct bma400_dev *dev) {
 	return rslt;
 }
 
+int8_t bma400_init_async(struct bma400_bringup *bu, bma400_bringup_cb_t notify,
+		void *cb_ctx, struct bma400_dev *dev) {
+	int8_t rslt;
+
+	/* Check for null pointer in the device structure*/
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (bu != NULL)) {
+		if (bu->state != BMA400_BRINGUP_IDLE) {
+			rslt = BMA400_E_BUSY;
+		} else {
+			dev->dummy_byte = (dev->intf == BMA400_SPI_INTF) ? 1 : 0;
+			bu->dev = dev;
+			bu->notify = notify;
+			bu->cb_ctx = cb_ctx;
+
+			/* A sensor that is already powered answers right away */
+			rslt = bringup_start(bu, BMA400_BRINGUP_POWER_UP, 0,
+					BMA400_POWER_UP_TIMEOUT_MS);
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_soft_reset_async(struct bma400_bringup *bu,
+		bma400_bringup_cb_t notify, void *cb_ctx, struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t data = BMA400_SOFT_RESET_CMD;
+
+	/* Check for null pointer in the device structure*/
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (bu != NULL)) {
+		if (bu->state != BMA400_BRINGUP_IDLE) {
+			rslt = BMA400_E_BUSY;
+		} else {
+			rslt = bma400_set_regs(BMA400_COMMAND_REG_ADDR, &data, 1, dev);
+
+			/* Registers are back to their default values */
+			(void) bma400_shadow_invalidate(dev);
+			if (rslt == BMA400_OK) {
+				bu->dev = dev;
+				bu->notify = notify;
+				bu->cb_ctx = cb_ctx;
+
+				/* The old register contents, chip-id included, stay
+				 * readable until the reset takes effect
+				 */
+				rslt = bringup_start(bu, BMA400_BRINGUP_SOFT_RESET,
+						BMA400_SOFT_RESET_DELAY_MS,
+						BMA400_SOFT_RESET_TIMEOUT_MS);
+			}
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_set_power_mode_async(struct bma400_bringup *bu,
+		uint8_t power_mode, bma400_bringup_cb_t notify, void *cb_ctx,
+		struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t reg_data = 0;
+
+	/* Check for null pointer in the device structure*/
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (bu != NULL)) {
+		if (bu->state != BMA400_BRINGUP_IDLE) {
+			rslt = BMA400_E_BUSY;
+		} else {
+			rslt = bma400_get_regs(BMA400_ACCEL_CONFIG_0_ADDR, &reg_data, 1,
+					dev);
+		}
+		if (rslt == BMA400_OK) {
+			reg_data = BMA400_SET_BITS_POS_0(reg_data, BMA400_POWER_MODE,
+					power_mode);
+			rslt = bma400_set_regs(BMA400_ACCEL_CONFIG_0_ADDR, &reg_data, 1,
+					dev);
+		}
+		if (rslt == BMA400_OK) {
+			bu->dev = dev;
+			bu->notify = notify;
+			bu->cb_ctx = cb_ctx;
+			bu->power_mode = power_mode;
+
+			/* Low power mode runs at 25Hz and takes up to 1/ODR */
+			rslt = bringup_start(bu, BMA400_BRINGUP_POWER_MODE, 0,
+					(power_mode == BMA400_LOW_POWER_MODE) ?
+							BMA400_LP_SWITCH_TIMEOUT_MS :
+							BMA400_POWER_SWITCH_TIMEOUT_MS);
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_bringup_process(struct bma400_bringup *bu) {
+	int8_t rslt = BMA400_OK;
+
+	if (bu == NULL) {
+		rslt = BMA400_E_NULL_PTR;
+	} else if (bu->state != BMA400_BRINGUP_IDLE) {
+		if (bu->pending) {
+			bu->pending = FALSE;
+			rslt = bringup_poll(bu);
+		} else {
+			rslt = BMA400_W_IN_PROGRESS;
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_bringup_abort(struct bma400_bringup *bu) {
+	int8_t rslt = BMA400_OK;
+
+	if (bu != NULL) {
+		if (bu->state != BMA400_BRINGUP_IDLE) {
+			(void) sl_sleeptimer_stop_timer(&bu->timer);
+			bu->state = BMA400_BRINGUP_IDLE;
+			bu->pending = FALSE;
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
 int8_t bma400_get_power_mode(uint8_t *power_mode, const struct bma400_dev *dev) {
 	int8_t rslt;
 	uint8_t reg_data;
@@ -948,6 +2246,144 @@ int8_t bma400_set_sensor_conf(const struct bma400_sensor_conf *conf,
 	return rslt;
 }
 
+int8_t bma400_apply_conf(const struct bma400_sensor_conf *sensor_conf,
+		uint16_t n_sensor, const struct bma400_device_conf *device_conf,
+		uint8_t n_device, uint8_t *n_written, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t idx;
+	uint8_t count = 0;
+	uint8_t current[BMA400_CONF_IMAGE_LEN];
+	uint8_t target[BMA400_CONF_IMAGE_LEN];
+	struct bma400_reg_batch batch;
+
+	/* Check for null pointer in the device structure*/
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && ((sensor_conf != NULL) || (n_sensor == 0))
+			&& ((device_conf != NULL) || (n_device == 0))) {
+		/* Current configuration, from the shadow when available or
+		 * else in a single burst read
+		 */
+		rslt = bma400_get_regs(BMA400_CONF_IMAGE_START_ADDR, current,
+				BMA400_CONF_IMAGE_LEN, dev);
+		if (rslt == BMA400_OK) {
+			for (idx = 0; idx < BMA400_CONF_IMAGE_LEN; idx++) {
+				target[idx] = current[idx];
+			}
+			rslt = pack_conf_image(target, sensor_conf, n_sensor, device_conf,
+					n_device);
+		}
+
+		/* Only the registers that differ are written, all of them
+		 * within one transaction as long as they fit in a batch
+		 */
+		batch.n_regs = 0;
+		for (idx = 0; (idx < BMA400_CONF_IMAGE_LEN) && (rslt == BMA400_OK);
+				idx++) {
+			if (target[idx] != current[idx]) {
+				if (batch.n_regs == BMA400_REG_BATCH_MAX_REGS) {
+					rslt = bma400_batch_write(&batch, NULL, dev);
+				}
+				if (rslt == BMA400_OK) {
+					rslt = bma400_batch_add_regs(
+							BMA400_CONF_IMAGE_START_ADDR + idx, &target[idx], 1,
+							&batch);
+					count++;
+				}
+			}
+		}
+		if (rslt == BMA400_OK) {
+			rslt = bma400_batch_write(&batch, NULL, dev);
+		}
+		if (n_written != NULL) {
+			*n_written = count;
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_boot_image_build(const struct bma400_sensor_conf *sensor_conf,
+		uint16_t n_sensor, const struct bma400_device_conf *device_conf,
+		uint8_t n_device, uint8_t power_mode, struct bma400_boot_image *image) {
+	int8_t rslt;
+	uint8_t idx;
+	uint8_t reset[BMA400_CONF_IMAGE_LEN];
+
+	if ((image != NULL) && ((sensor_conf != NULL) || (n_sensor == 0))
+			&& ((device_conf != NULL) || (n_device == 0))) {
+		reset_conf_image(reset);
+		memcpy(image->regs, reset, sizeof(image->regs));
+		rslt = pack_conf_image(image->regs, sensor_conf, n_sensor,
+				device_conf, n_device);
+		if (rslt == BMA400_OK) {
+			image->regs[0] = BMA400_SET_BITS_POS_0(image->regs[0],
+					BMA400_POWER_MODE, power_mode);
+
+			/* ACCEL_CONFIG_0 at index 0 is queued after all others */
+			image->n_regs = 0;
+			for (idx = 1; idx <= BMA400_CONF_IMAGE_LEN; idx++) {
+				if (image->regs[idx % BMA400_CONF_IMAGE_LEN]
+						!= reset[idx % BMA400_CONF_IMAGE_LEN]) {
+					image->pairs[2 * image->n_regs] =
+							(uint8_t) (BMA400_CONF_IMAGE_START_ADDR
+									+ (idx % BMA400_CONF_IMAGE_LEN))
+									& BMA400_SPI_WR_MASK;
+					image->pairs[(2 * image->n_regs) + 1] =
+							image->regs[idx % BMA400_CONF_IMAGE_LEN];
+					image->n_regs++;
+				}
+			}
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_boot(const struct bma400_boot_image *image,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t count = 0;
+	uint8_t chunk;
+	struct bma400_reg_batch batch;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (image != NULL)) {
+		/* Everything else in the image window is still at its reset
+		 * value, so the whole window becomes known without a read
+		 */
+		(void) bma400_shadow_invalidate(dev);
+		shadow_update(BMA400_CONF_IMAGE_START_ADDR, image->regs,
+				BMA400_CONF_IMAGE_LEN, dev);
+		while ((rslt == BMA400_OK) && (count < image->n_regs)) {
+			chunk = image->n_regs - count;
+			if (chunk > BMA400_REG_BATCH_MAX_REGS) {
+				chunk = BMA400_REG_BATCH_MAX_REGS;
+			}
+			memcpy(batch.pairs, &image->pairs[2 * count], 2 * chunk);
+			batch.n_regs = chunk;
+			rslt = bma400_batch_write(&batch, NULL, dev);
+			count += chunk;
+		}
+		if (rslt != BMA400_OK) {
+			/* The sensor is in an unknown partial state */
+			(void) bma400_shadow_invalidate(dev);
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
 int8_t bma400_get_sensor_conf(struct bma400_sensor_conf *conf, uint16_t n_sett,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
@@ -1216,6 +2652,72 @@ int8_t bma400_get_steps_counted(uint32_t *step_count, uint8_t *activity_data,
 	return rslt;
 }
 
+int8_t bma400_get_status_snapshot(struct bma400_status_snapshot *snap,
+		uint8_t read_steps, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t buffer[BMA400_STATUS_BLOCK_LEN + BMA400_READ_HEADROOM];
+	const uint8_t *reg;
+	const uint8_t *int_stat;
+	const uint8_t *fifo_len;
+	uint8_t step_data[4];
+	uint8_t status;
+	uint8_t int_stat1;
+	int8_t temp;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (snap != NULL)) {
+		/* One burst from STATUS */
+		rslt = bma400_get_regs_inplace(BMA400_STATUS_ADDR, buffer,
+				BMA400_STATUS_BLOCK_LEN, dev);
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+	if (rslt == BMA400_OK) {
+		/* reg[0] is STATUS, the others at their address offset */
+		reg = &buffer[1 + dev->dummy_byte];
+		status = reg[0];
+		snap->power_mode = BMA400_GET_BITS(status, BMA400_POWER_MODE_STATUS);
+		snap->drdy = BMA400_GET_BITS(status, BMA400_DRDY_STAT);
+		snap->por_detected = BMA400_GET_BITS_POS_0(
+				reg[BMA400_EVENT_ADDR - BMA400_STATUS_ADDR],
+				BMA400_POR_DETECTED);
+
+		/* The sensor time follows the accel data registers */
+		unpack_sensor_data(&reg[BMA400_ACCEL_DATA_ADDR - BMA400_STATUS_ADDR],
+				BMA400_DATA_SENSOR_TIME, &snap->accel);
+
+		/* Same layout as bma400_get_interrupt_status */
+		int_stat = &reg[BMA400_INT_STAT0_ADDR - BMA400_STATUS_ADDR];
+		int_stat1 = BMA400_SET_BITS(int_stat[1], BMA400_INT_STATUS,
+				int_stat[2]);
+		snap->int_status = ((uint16_t) int_stat1 << 8) | int_stat[0];
+
+		/* Same scaling as bma400_get_temperature_data */
+		temp = (int8_t) reg[BMA400_TEMP_DATA_ADDR - BMA400_STATUS_ADDR];
+		snap->temperature = (((int16_t) temp) - 2) * 5 + 250;
+
+		fifo_len = &reg[BMA400_FIFO_LENGTH_ADDR - BMA400_STATUS_ADDR];
+		snap->fifo_length = ((uint16_t) BMA400_GET_BITS_POS_0(fifo_len[1],
+				BMA400_FIFO_BYTES_CNT) << 8) | fifo_len[0];
+		snap->step_count = 0;
+		snap->activity = 0;
+		if (read_steps == BMA400_ENABLE) {
+			/* Behind the FIFO data register, so in a second burst */
+			rslt = bma400_get_regs(BMA400_STEP_CNT_0_ADDR, step_data, 4, dev);
+		}
+		if ((read_steps == BMA400_ENABLE) && (rslt == BMA400_OK)) {
+			snap->step_count = ((uint32_t) step_data[2] << 16)
+					| ((uint16_t) step_data[1] << 8) | step_data[0];
+			snap->activity = step_data[3];
+		}
+	}
+
+	return rslt;
+}
+
 int8_t bma400_get_temperature_data(int16_t *temperature_data,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
@@ -1235,30 +2737,82 @@ int8_t bma400_get_temperature_data(int16_t *temperature_data,
 	return rslt;
 }
 
-int8_t bma400_get_interrupts_enabled(struct bma400_int_enable *int_select,
-		uint8_t n_sett, const struct bma400_dev *dev) {
+int8_t bma400_lsb_to_mg(const int16_t *lsb, int16_t *mg, uint16_t n,
+		uint8_t range, uint8_t resolution) {
 	int8_t rslt;
-	uint8_t idx = 0;
-	uint8_t reg_data[2];
-	uint8_t wkup_int;
-
-	/* Check for null pointer in the device structure */
-	rslt = null_ptr_check(dev);
+	uint16_t idx;
+	uint8_t frac_bits = 0;
+	int32_t mult;
+	int32_t round;
 
-	/* Proceed if null check is fine */
-	if (rslt == BMA400_OK) {
-		rslt = bma400_get_regs(BMA400_INT_CONF_0_ADDR, reg_data, 2, dev);
+	if ((lsb != NULL) && (mg != NULL)) {
+		rslt = unit_conv_frac_bits(resolution, range, &frac_bits);
 		if (rslt == BMA400_OK) {
-			for (idx = 0; idx < n_sett; idx++) {
-				/* Read the enable/disable of interrupts
-				 * based on user selection
-				 */
-				switch (int_select[idx].type) {
-				case BMA400_DRDY_INT_EN:
-					int_select[idx].conf = BMA400_GET_BITS(reg_data[0],
-							BMA400_EN_DRDY);
-					break;
-				case BMA400_FIFO_WM_INT_EN:
+			/* One multiply, add and shift per sample, rounded to nearest */
+			mult = lsb_to_mg_q7[range];
+			round = (int32_t) 1 << (frac_bits - 1);
+			for (idx = 0; idx < n; idx++) {
+				mg[idx] = (int16_t) (((int32_t) lsb[idx] * mult + round)
+						>> frac_bits);
+			}
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_lsb_to_q15_g(const int16_t *lsb, int32_t *g_q15, uint16_t n,
+		uint8_t range, uint8_t resolution) {
+	int8_t rslt;
+	uint16_t idx;
+	uint8_t frac_bits = 0;
+	uint8_t shift;
+
+	if ((lsb != NULL) && (g_q15 != NULL)) {
+		rslt = unit_conv_frac_bits(resolution, range, &frac_bits);
+		if (rslt == BMA400_OK) {
+			/*
+			 * 1 g is 2^(resolution - 2 - range) LSB, so the Q15 value is
+			 * an exact left shift by 17 - resolution + range
+			 */
+			shift = (uint8_t) (17 - resolution + range);
+			for (idx = 0; idx < n; idx++) {
+				g_q15[idx] = (int32_t) lsb[idx] * ((int32_t) 1 << shift);
+			}
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_get_interrupts_enabled(struct bma400_int_enable *int_select,
+		uint8_t n_sett, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t idx = 0;
+	uint8_t reg_data[2];
+	uint8_t wkup_int;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if (rslt == BMA400_OK) {
+		rslt = bma400_get_regs(BMA400_INT_CONF_0_ADDR, reg_data, 2, dev);
+		if (rslt == BMA400_OK) {
+			for (idx = 0; idx < n_sett; idx++) {
+				/* Read the enable/disable of interrupts
+				 * based on user selection
+				 */
+				switch (int_select[idx].type) {
+				case BMA400_DRDY_INT_EN:
+					int_select[idx].conf = BMA400_GET_BITS(reg_data[0],
+							BMA400_EN_DRDY);
+					break;
+				case BMA400_FIFO_WM_INT_EN:
 					int_select[idx].conf = BMA400_GET_BITS(reg_data[0],
 							BMA400_EN_FIFO_WM);
 					break;
@@ -1402,56 +2956,473 @@ int8_t bma400_enable_interrupt(const struct bma400_int_enable *int_select,
 int8_t bma400_get_fifo_data(struct bma400_fifo_data *fifo,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
-	uint8_t data;
-	uint16_t fifo_byte_cnt = 0;
-	uint16_t user_fifo_len = 0;
 
 	/* Check for null pointer in the device structure */
 	rslt = null_ptr_check(dev);
 
 	/* Proceed if null check is fine */
 	if (rslt == BMA400_OK) {
-		/* Resetting the FIFO data byte index */
-		fifo->accel_byte_start_idx = 0;
-
-		/* Reading the FIFO length */
-		rslt = get_fifo_length(&fifo_byte_cnt, dev);
+		/* Get the FIFO length and configurations, the start of
+		 * the buffer is kept for the address and dummy bytes
+		 */
+		rslt = prepare_fifo_read(fifo,
+				BMA400_FIFO_HEADROOM + dev->dummy_byte, dev);
 		if (rslt == BMA400_OK) {
-			/* Get the FIFO configurations
-			 * from the sensor */
-			rslt = bma400_get_regs(BMA400_FIFO_CONFIG_0_ADDR, &data, 1, dev);
-			if (rslt == BMA400_OK) {
-				/* Get the data from FIFO_CONFIG0 register */
-				fifo->fifo_8_bit_en = BMA400_GET_BITS(data,
-						BMA400_FIFO_8_BIT_EN);
-				fifo->fifo_data_enable = BMA400_GET_BITS(data,
-						BMA400_FIFO_AXES_EN);
-				fifo->fifo_time_enable = BMA400_GET_BITS(data,
-						BMA400_FIFO_TIME_EN);
-				fifo->fifo_sensor_time = 0;
-				user_fifo_len = fifo->length;
-				if (fifo->length > fifo_byte_cnt) {
-					/* Handling case where user requests
-					 * more data than available in FIFO
-					 */
-					fifo->length = fifo_byte_cnt;
-				}
+			/* Read the FIFO data in place */
+			fifo->length = fifo->length + BMA400_FIFO_HEADROOM
+					+ dev->dummy_byte;
+			rslt = read_fifo(fifo, dev);
+		}
+		if (rslt == BMA400_OK) {
+			/* Parsing starts after the address and dummy bytes */
+			fifo->accel_byte_start_idx = BMA400_FIFO_HEADROOM
+					+ dev->dummy_byte;
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_get_fifo_data_async(struct bma400_fifo_data *fifo,
+		bma400_fifo_cb_t callback, void *cb_ctx, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t was_disabled;
 
-				/* Reading extra bytes as per the macro
-				 * "BMA400_FIFO_BYTES_OVERREAD"
-				 * when FIFO time is enabled
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (fifo != NULL) && (fifo->data != NULL)
+			&& (callback != NULL) && (dev->intf_ptr != NULL)) {
+		if (fifo_async.busy) {
+			rslt = BMA400_E_BUSY;
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+	if (rslt == BMA400_OK) {
+		/* Length and configuration are read before the transfer,
+		 * the start of the buffer is kept for the address and dummy
+		 * bytes
+		 */
+		rslt = prepare_fifo_read(fifo,
+				BMA400_FIFO_HEADROOM + dev->dummy_byte, dev);
+	}
+	if (rslt == BMA400_OK) {
+		/* FIFO reading is left enabled, as the completion runs in
+		 * interrupt context where no register access can be made
+		 */
+		rslt = enable_fifo_read(&was_disabled, dev);
+	}
+	if (rslt == BMA400_OK) {
+		fifo_async.fifo = fifo;
+		fifo_async.callback = callback;
+		fifo_async.cb_ctx = cb_ctx;
+		fifo_async.start_idx = BMA400_FIFO_HEADROOM + dev->dummy_byte;
+		fifo_async.busy = TRUE;
+
+		/* The transfer runs in place, the address byte is sent from
+		 * the start of the buffer that receives the FIFO data
+		 */
+		fifo->data[0] = BMA400_FIFO_DATA_ADDR | BMA400_SPI_RD_MASK;
+		fifo->length = fifo->length + fifo_async.start_idx;
+
+		/* Ahead of the bulk transfers of other devices on the bus */
+		fifo_async.xfer.spi = (const struct bma400_spi_dev *) dev->intf_ptr;
+		fifo_async.xfer.tx_data = fifo->data;
+		fifo_async.xfer.rx_data = fifo->data;
+		fifo_async.xfer.length = fifo->length;
+		fifo_async.xfer.n_segs = 0;
+		fifo_async.xfer.priority = BMA400_SPI_PRIO_URGENT;
+		fifo_async.xfer.callback = fifo_async_done;
+		fifo_async.xfer.cb_ctx = NULL;
+		rslt = bma400_spi_submit(&fifo_async.xfer);
+		if (rslt != BMA400_OK) {
+			fifo_async.busy = FALSE;
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_fifo_acq_start(struct bma400_fifo_acq *acq, uint8_t *buf0,
+		uint8_t *buf1, uint16_t length, uint32_t bit_rate,
+		bma400_fifo_cb_t callback, void *cb_ctx, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t was_disabled;
+	uint8_t index;
+	uint16_t data_start;
+	Ecode_t ecode;
+	const struct bma400_spi_dev *spi;
+	SPIDRV_Handle_t handle;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (acq != NULL) && (buf0 != NULL)
+			&& (buf1 != NULL) && (callback != NULL) && (dev->intf_ptr != NULL)) {
+		spi = (const struct bma400_spi_dev *) dev->intf_ptr;
+		handle = &spi->bus->handle;
+		data_start = BMA400_FIFO_HEADROOM + dev->dummy_byte;
+		if ((length <= data_start)
+				|| ((length - data_start) > DMADRV_MAX_XFER_COUNT)) {
+			rslt = BMA400_E_INVALID_CONFIG;
+		} else if (fifo_async.busy) {
+			rslt = BMA400_E_BUSY;
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+	if (rslt == BMA400_OK) {
+		/* FIFO reading is left enabled, the DMA reads the FIFO data
+		 * register until the acquisition is stopped
+		 */
+		rslt = enable_fifo_read(&was_disabled, dev);
+	}
+	if ((rslt == BMA400_OK) && !spi_bus_claim(spi->bus, &fifo_acq_xfer)) {
+		/* The acquisition keeps the bus until it is stopped, so it
+		 * only starts once the queue is empty
+		 */
+		rslt = BMA400_E_BUSY;
+	}
+	if (rslt == BMA400_OK) {
+		acq->fifo[0].data = buf0;
+		acq->fifo[1].data = buf1;
+		for (index = 0; index < 2; index++) {
+			acq->fifo[index].length = length;
+			acq->fifo[index].accel_byte_start_idx = data_start;
+			acq->fifo[index].fifo_sensor_time = 0;
+			acq->fifo[index].fifo_sensor_time_avail = FALSE;
+			acq->fifo[index].conf_change = 0;
+		}
+		acq->callback = callback;
+		acq->cb_ctx = cb_ctx;
+		acq->dev = dev;
+		acq->running = TRUE;
+		fifo_async.busy = TRUE;
+
+		/* The chip select is held low for the whole acquisition */
+		spi_select(spi);
+		if (bit_rate != 0) {
+			/* Bit rate matched to the FIFO data rate */
+			USART_BaudrateSyncSet(handle->initData.port, 0, bit_rate);
+		}
+
+		/* Address and dummy bytes once, then FIFO data only */
+		(void) USART_SpiTransfer(handle->initData.port,
+				BMA400_FIFO_DATA_ADDR | BMA400_SPI_RD_MASK);
+		for (index = 0; index < dev->dummy_byte; index++) {
+			(void) USART_SpiTransfer(handle->initData.port, 0);
+		}
+
+		/* Receive into the two buffers in turn, behind the same
+		 * headroom as a FIFO read. The TX clocks out dummy bytes.
+		 */
+		ecode = DMADRV_PeripheralMemoryPingPong(handle->rxDMACh,
+				handle->rxDMASignal, &buf0[data_start], &buf1[data_start],
+				(void *) &handle->initData.port->RXDATA, true,
+				length - data_start, dmadrvDataSize1, fifo_acq_done, acq);
+		if (ecode == ECODE_EMDRV_DMADRV_OK) {
+			ecode = DMADRV_MemoryPeripheralPingPong(handle->txDMACh,
+					handle->txDMASignal, (void *) &handle->initData.port->TXDATA,
+					&fifo_acq_tx_dummy, &fifo_acq_tx_dummy, false,
+					length - data_start, dmadrvDataSize1, NULL, NULL);
+		}
+		if (ecode != ECODE_EMDRV_DMADRV_OK) {
+			acq->running = FALSE;
+			fifo_acq_release(spi);
+			fifo_async.busy = FALSE;
+			rslt = BMA400_E_COM_FAIL;
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_fifo_acq_stop(struct bma400_fifo_acq *acq) {
+	int8_t rslt = BMA400_OK;
+
+	if ((acq != NULL) && (acq->dev != NULL)) {
+		if (acq->running) {
+			acq->running = FALSE;
+			fifo_acq_release(
+					(const struct bma400_spi_dev *) acq->dev->intf_ptr);
+			fifo_async.busy = FALSE;
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_fifo_wm_acq_start(struct bma400_fifo_wm_acq *acq,
+		uint16_t watermark, enum bma400_int_chan int_chan, uint8_t gpio_port,
+		uint8_t gpio_pin, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t n_written;
+	struct bma400_device_conf conf[2];
+	struct bma400_int_enable int_en;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (acq != NULL)) {
+		if (((int_chan != BMA400_INT_CHANNEL_1)
+				&& (int_chan != BMA400_INT_CHANNEL_2))
+				|| (gpio_pin >= BMA400_GPIO_INT_COUNT)
+				|| (watermark > BMA400_FIFO_BYTES_MAX)) {
+			rslt = BMA400_E_INVALID_CONFIG;
+		} else if ((fifo_wm_acq[gpio_pin] != NULL)
+				|| ((dma_poll != NULL) && (dma_poll->gpio_pin == gpio_pin))) {
+			rslt = BMA400_E_BUSY;
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+	if (rslt == BMA400_OK) {
+		/* The other FIFO settings are kept */
+		conf[0].type = BMA400_FIFO_CONF;
+		rslt = bma400_get_device_conf(&conf[0], 1, dev);
+	}
+	if (rslt == BMA400_OK) {
+		/* FIFO_CONFIG0 is written back as read */
+		conf[0].param.fifo_conf.conf_status = BMA400_ENABLE;
+		conf[0].param.fifo_conf.fifo_watermark = watermark;
+		conf[0].param.fifo_conf.fifo_wm_channel = int_chan;
+
+		/* Active high push-pull pin, the GPIO triggers on the
+		 * rising edge
+		 */
+		conf[1].type = BMA400_INT_PIN_CONF;
+		conf[1].param.int_conf.int_chan = int_chan;
+		conf[1].param.int_conf.pin_conf = BMA400_INT_PUSH_PULL_ACTIVE_1;
+		rslt = bma400_apply_conf(NULL, 0, conf, 2, &n_written, dev);
+	}
+	if (rslt == BMA400_OK) {
+		acq->gpio_port = gpio_port;
+		acq->gpio_pin = gpio_pin;
+		acq->pending = FALSE;
+		fifo_wm_acq[gpio_pin] = acq;
+
+		/* GPIO interrupts wake the MCU up from EM2 */
+		GPIO_PinModeSet((GPIO_Port_TypeDef) gpio_port, gpio_pin, gpioModeInput,
+				0);
+		GPIOINT_CallbackRegister(gpio_pin, fifo_wm_irq);
+		GPIO_ExtIntConfig((GPIO_Port_TypeDef) gpio_port, gpio_pin, gpio_pin,
+				true, false, true);
+
+		int_en.type = BMA400_FIFO_WM_INT_EN;
+		int_en.conf = BMA400_ENABLE;
+		rslt = bma400_enable_interrupt(&int_en, 1, dev);
+	}
+
+	return rslt;
+}
+
+int8_t bma400_fifo_wm_acq_read(struct bma400_fifo_wm_acq *acq,
+		struct bma400_fifo_data *fifo, const struct bma400_dev *dev) {
+	int8_t rslt;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (acq != NULL) && (fifo != NULL)) {
+		if (acq->pending) {
+			acq->pending = FALSE;
+			rslt = bma400_get_fifo_data(fifo, dev);
+			if (GPIO_PinInGet((GPIO_Port_TypeDef) acq->gpio_port,
+					acq->gpio_pin)) {
+				/* Still above the watermark, no new edge will
+				 * come, so the next call reads again
 				 */
-				if ((fifo->fifo_time_enable == BMA400_ENABLE)
-						&& (fifo_byte_cnt + BMA400_FIFO_BYTES_OVERREAD
-								<= user_fifo_len)) {
-					/* Handling sensor time availability*/
-					fifo->length = fifo->length + BMA400_FIFO_BYTES_OVERREAD;
-				}
+				acq->pending = TRUE;
+			}
+		} else {
+			rslt = BMA400_W_NO_DATA;
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
 
-				/* Read the FIFO data */
-				rslt = read_fifo(fifo, dev);
+	return rslt;
+}
+
+int8_t bma400_fifo_wm_acq_stop(struct bma400_fifo_wm_acq *acq,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	struct bma400_int_enable int_en;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (acq != NULL)) {
+		GPIO_ExtIntConfig((GPIO_Port_TypeDef) acq->gpio_port, acq->gpio_pin,
+				acq->gpio_pin, true, false, false);
+		GPIOINT_CallbackUnRegister(acq->gpio_pin);
+		fifo_wm_acq[acq->gpio_pin] = NULL;
+		acq->pending = FALSE;
+
+		int_en.type = BMA400_FIFO_WM_INT_EN;
+		int_en.conf = BMA400_DISABLE;
+		rslt = bma400_enable_interrupt(&int_en, 1, dev);
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_dma_poll_start(struct bma400_dma_poll *poll, uint8_t batch,
+		enum bma400_int_chan int_chan, uint8_t gpio_port, uint8_t gpio_pin,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t n_written;
+	Ecode_t ecode;
+	struct bma400_sensor_conf sensor_conf;
+	struct bma400_device_conf device_conf;
+	struct bma400_int_enable int_en[2];
+	const struct bma400_spi_dev *spi;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (poll != NULL) && (dev->intf_ptr != NULL)) {
+		spi = (const struct bma400_spi_dev *) dev->intf_ptr;
+		if (((int_chan != BMA400_INT_CHANNEL_1)
+				&& (int_chan != BMA400_INT_CHANNEL_2)) || (batch == 0)
+				|| (batch > BMA400_DMA_POLL_MAX_BATCH)
+				|| (gpio_pin >= BMA400_GPIO_INT_COUNT)) {
+			rslt = BMA400_E_INVALID_CONFIG;
+		} else if ((dma_poll != NULL) || (fifo_wm_acq[gpio_pin] != NULL)) {
+			rslt = BMA400_E_BUSY;
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+	if (rslt == BMA400_OK) {
+		/* The other accel settings are kept */
+		sensor_conf.type = BMA400_ACCEL;
+		rslt = bma400_get_sensor_conf(&sensor_conf, 1, dev);
+	}
+	if (rslt == BMA400_OK) {
+		/* Restored by the stop */
+		int_en[0].type = BMA400_LATCH_INT_EN;
+		rslt = bma400_get_interrupts_enabled(&int_en[0], 1, dev);
+		poll->latch = int_en[0].conf;
+	}
+	if (rslt == BMA400_OK) {
+		/* Data ready on an active high push-pull pin, each new sample
+		 * makes a rising edge
+		 */
+		sensor_conf.param.accel.int_chan = int_chan;
+		device_conf.type = BMA400_INT_PIN_CONF;
+		device_conf.param.int_conf.int_chan = int_chan;
+		device_conf.param.int_conf.pin_conf = BMA400_INT_PUSH_PULL_ACTIVE_1;
+		rslt = bma400_apply_conf(&sensor_conf, 1, &device_conf, 1, &n_written,
+				dev);
+	}
+	if (rslt == BMA400_OK) {
+		/* The frames never read INT_STAT, so a latched data ready
+		 * would hold the pin high after the first sample
+		 */
+		int_en[0].type = BMA400_DRDY_INT_EN;
+		int_en[0].conf = BMA400_ENABLE;
+		int_en[1].type = BMA400_LATCH_INT_EN;
+		int_en[1].conf = BMA400_DISABLE;
+		rslt = bma400_enable_interrupt(int_en, 2, dev);
+	}
+	if (rslt == BMA400_OK) {
+		ecode = DMADRV_AllocateChannel(&poll->trig_ch, NULL);
+		if (ecode != ECODE_EMDRV_DMADRV_OK) {
+			rslt = BMA400_E_COM_FAIL;
+		} else if (!spi_bus_claim(spi->bus, &dma_poll_xfer)) {
+			/* The polling keeps the bus until it is stopped, so it
+			 * only starts once the queue is empty
+			 */
+			(void) DMADRV_FreeChannel(poll->trig_ch);
+			rslt = BMA400_E_BUSY;
+		}
+	}
+	if (rslt == BMA400_OK) {
+		poll->batch = batch;
+		poll->gpio_port = gpio_port;
+		poll->gpio_pin = gpio_pin;
+		poll->dev = dev;
+		poll->filled = 0;
+		poll->next = 0;
+		poll->overruns = 0;
+		poll->in_flight = 0;
+		poll->running = TRUE;
+		dma_poll = poll;
+		rslt = dma_poll_arm(poll, spi);
+		if (rslt != BMA400_OK) {
+			dma_poll_release(poll);
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_dma_poll_read(struct bma400_dma_poll *poll,
+		struct bma400_sensor_data *accel, uint8_t *n_samples) {
+	int8_t rslt = BMA400_OK;
+	const uint8_t *frame;
+	uint8_t idx;
+	CORE_DECLARE_IRQ_STATE;
+
+	if ((poll != NULL) && (accel != NULL) && (n_samples != NULL)) {
+		if (poll->filled & (1 << poll->next)) {
+			for (idx = 0; idx < poll->batch; idx++) {
+				/* Data behind the address and dummy bytes */
+				frame = poll->frames[(poll->next * poll->batch) + idx];
+				unpack_sensor_data(&frame[BMA400_READ_HEADROOM],
+						BMA400_DATA_SENSOR_TIME, &accel[idx]);
 			}
+			*n_samples = poll->batch;
+
+			CORE_ENTER_ATOMIC();
+			poll->filled &= ~(1 << poll->next);
+			CORE_EXIT_ATOMIC();
+			poll->next ^= 1;
+		} else {
+			*n_samples = 0;
+			rslt = BMA400_W_NO_DATA;
 		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_dma_poll_stop(struct bma400_dma_poll *poll,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	struct bma400_int_enable int_en[2];
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (poll != NULL)) {
+		if (poll->running) {
+			dma_poll_release(poll);
+		}
+
+		/* The bus is free again for the register write */
+		int_en[0].type = BMA400_DRDY_INT_EN;
+		int_en[0].conf = BMA400_DISABLE;
+		int_en[1].type = BMA400_LATCH_INT_EN;
+		int_en[1].conf = poll->latch;
+		rslt = bma400_enable_interrupt(int_en, 2, dev);
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
 	}
 
 	return rslt;
@@ -1461,14 +3432,453 @@ int8_t bma400_extract_accel(struct bma400_fifo_data *fifo,
 		struct bma400_sensor_data *accel_data, uint16_t *frame_count,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
+	struct accel_out out;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if (rslt == BMA400_OK) {
+		/* Frames are stored as an array of structures */
+		out.x = (uint8_t *) accel_data
+				+ offsetof(struct bma400_sensor_data, x);
+		out.y = (uint8_t *) accel_data
+				+ offsetof(struct bma400_sensor_data, y);
+		out.z = (uint8_t *) accel_data
+				+ offsetof(struct bma400_sensor_data, z);
+		out.stride = sizeof(struct bma400_sensor_data);
+
+		/* Parse the FIFO data */
+		unpack_accel_frame(fifo, &out, frame_count, NULL, dev);
+	}
+
+	return rslt;
+}
+
+int8_t bma400_extract_accel_soa(struct bma400_fifo_data *fifo,
+		const struct bma400_accel_soa *accel_data, uint16_t *frame_count,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint16_t index;
+	struct accel_out out;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (accel_data != NULL) && (accel_data->x != NULL)
+			&& (accel_data->y != NULL) && (accel_data->z != NULL)) {
+		/* Frames are stored in contiguous arrays */
+		out.x = (uint8_t *) accel_data->x;
+		out.y = (uint8_t *) accel_data->y;
+		out.z = (uint8_t *) accel_data->z;
+		out.stride = sizeof(int16_t);
+
+		/* Parse the FIFO data */
+		unpack_accel_frame(fifo, &out, frame_count, NULL, dev);
+		if (accel_data->sensortime != NULL) {
+			for (index = 0; index < *frame_count; index++) {
+				/* Sensor time of the batch */
+				accel_data->sensortime[index] = fifo->fifo_sensor_time;
+			}
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_sensortime_reset(struct bma400_sensortime *sensortime) {
+	int8_t rslt = BMA400_OK;
+
+	if (sensortime != NULL) {
+		/* The next raw value starts the clock */
+		sensortime->time = 0;
+		sensortime->next_frame = 0;
+		sensortime->raw = 0;
+		sensortime->time_valid = FALSE;
+		sensortime->next_frame_valid = FALSE;
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_sensortime_extend(struct bma400_sensortime *sensortime,
+		uint32_t raw, uint64_t *time) {
+	int8_t rslt = BMA400_OK;
+
+	if ((sensortime != NULL) && (time != NULL)) {
+		raw = raw & BMA400_SENSORTIME_MASK;
+		if (sensortime->time_valid == TRUE) {
+			/* The 24 bit difference is right across a wrap */
+			sensortime->time += (raw - sensortime->raw)
+					& BMA400_SENSORTIME_MASK;
+		} else {
+			sensortime->time = raw;
+			sensortime->time_valid = TRUE;
+		}
+		sensortime->raw = raw;
+		*time = sensortime->time;
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_fifo_timestamps(struct bma400_sensortime *sensortime,
+		const struct bma400_fifo_data *fifo, uint16_t frame_count,
+		uint8_t odr, uint64_t *timestamps) {
+	int8_t rslt = BMA400_OK;
+	uint64_t time;
+	uint64_t first;
+	uint32_t ticks;
+	uint16_t index;
+
+	if ((sensortime == NULL) || (fifo == NULL) || (timestamps == NULL)) {
+		rslt = BMA400_E_NULL_PTR;
+	} else if ((odr < BMA400_ODR_12_5HZ) || (odr > BMA400_ODR_800HZ)) {
+		rslt = BMA400_E_INVALID_CONFIG;
+	}
+	if ((rslt == BMA400_OK) && (frame_count > 0)) {
+		/* Sensor time ticks between two samples */
+		ticks = (uint32_t) 1 << (BMA400_SENSORTIME_ODR_SHIFT - odr);
+		if (fifo->fifo_sensor_time_avail == TRUE) {
+			/* The sensor time frame follows the last frame, which
+			 * was sampled on the last multiple of the sample period
+			 */
+			(void) bma400_sensortime_extend(sensortime, fifo->fifo_sensor_time,
+					&time);
+			time = time & ~((uint64_t) ticks - 1);
+			first = (uint64_t) (frame_count - 1) * ticks;
+			first = (time > first) ? (time - first) : 0;
+			if ((sensortime->next_frame_valid == TRUE)
+					&& (first < sensortime->next_frame)) {
+				/* Timestamps stay monotonic */
+				first = sensortime->next_frame;
+			}
+		} else if (sensortime->next_frame_valid == TRUE) {
+			/* No sensor time in this read, the frames follow the
+			 * previous ones
+			 */
+			first = sensortime->next_frame;
+		} else {
+			rslt = BMA400_W_NO_DATA;
+		}
+		if (rslt == BMA400_OK) {
+			for (index = 0; index < frame_count; index++) {
+				timestamps[index] = first + ((uint64_t) index * ticks);
+			}
+			sensortime->next_frame = first + ((uint64_t) frame_count * ticks);
+			sensortime->next_frame_valid = TRUE;
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_clock_sync_init(struct bma400_clock_sync *sync,
+		uint8_t gain_shift) {
+	int8_t rslt = BMA400_OK;
+
+	if (sync != NULL) {
+		/* Start from the nominal rate of both clocks */
+		sync->rate = ((uint64_t) sl_sleeptimer_get_timer_frequency() << 32)
+				/ BMA400_SENSORTIME_FREQ_HZ;
+		sync->ref_sensortime = 0;
+		sync->ref_tick = 0;
+		sync->gain_shift = gain_shift;
+		sync->n_pairs = 0;
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_clock_sync_update(struct bma400_clock_sync *sync,
+		uint64_t sensortime, uint64_t tick) {
+	int8_t rslt = BMA400_OK;
+	uint64_t delta;
+	uint64_t measured;
+	uint64_t predicted;
+
+	if (sync == NULL) {
+		rslt = BMA400_E_NULL_PTR;
+	} else if ((sync->n_pairs > 0)
+			&& ((sensortime <= sync->ref_sensortime) || (tick < sync->ref_tick))) {
+		/* Pairs are given in time order */
+		rslt = BMA400_E_INVALID_CONFIG;
+	} else if ((sync->n_pairs > 0) && (((tick - sync->ref_tick) >> 32) != 0)) {
+		/* The tick difference is shifted up by 32 for the rate */
+		rslt = BMA400_E_INVALID_CONFIG;
+	}
+	if ((rslt == BMA400_OK) && (sync->n_pairs > 0)) {
+		/* Rate measured since the reference, it also corrects the
+		 * offset error left at the reference
+		 */
+		delta = sensortime - sync->ref_sensortime;
+		measured = ((tick - sync->ref_tick) << 32) / delta;
+		if (sync->n_pairs == 1) {
+			sync->rate = measured;
+		} else if (measured >= sync->rate) {
+			sync->rate += (measured - sync->rate) >> sync->gain_shift;
+		} else {
+			sync->rate -= (sync->rate - measured) >> sync->gain_shift;
+		}
+
+		/* The reference moves to the new pair, with the offset
+		 * filtered, so that conversions use short differences
+		 */
+		predicted = clock_sync_tick(sync, sensortime);
+		if (tick >= predicted) {
+			sync->ref_tick = predicted
+					+ ((tick - predicted) >> sync->gain_shift);
+		} else {
+			sync->ref_tick = predicted
+					- ((predicted - tick) >> sync->gain_shift);
+		}
+		sync->ref_sensortime = sensortime;
+	} else if (rslt == BMA400_OK) {
+		/* First pair */
+		sync->ref_sensortime = sensortime;
+		sync->ref_tick = tick;
+	}
+	if ((rslt == BMA400_OK) && (sync->n_pairs < UINT8_MAX)) {
+		sync->n_pairs++;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_clock_sync_sample(struct bma400_clock_sync *sync,
+		struct bma400_sensortime *sensortime, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t data_array[3];
+	uint64_t tick_before;
+	uint64_t tick_after;
+	uint64_t time;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (sync != NULL) && (sensortime != NULL)) {
+		/* The pair is taken in the middle of the read */
+		tick_before = sl_sleeptimer_get_tick_count64();
+		rslt = bma400_get_regs(BMA400_SENSOR_TIME_ADDR, data_array, 3, dev);
+		tick_after = sl_sleeptimer_get_tick_count64();
+		if (rslt == BMA400_OK) {
+			(void) bma400_sensortime_extend(sensortime,
+					((uint32_t) data_array[2] << 16)
+							| ((uint32_t) data_array[1] << 8) | data_array[0],
+					&time);
+			rslt = bma400_clock_sync_update(sync, time,
+					tick_before + ((tick_after - tick_before) / 2));
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_clock_sync_to_tick(const struct bma400_clock_sync *sync,
+		uint64_t sensortime, uint64_t *tick) {
+	int8_t rslt = BMA400_OK;
+
+	if ((sync == NULL) || (tick == NULL)) {
+		rslt = BMA400_E_NULL_PTR;
+	} else if (sync->n_pairs == 0) {
+		rslt = BMA400_W_NO_DATA;
+	} else {
+		*tick = clock_sync_tick(sync, sensortime);
+	}
+
+	return rslt;
+}
+
+#if SL_SLEEPTIMER_WALLCLOCK_CONFIG
+int8_t bma400_clock_sync_to_time(const struct bma400_clock_sync *sync,
+		uint64_t sensortime, sl_sleeptimer_timestamp_t *time) {
+	int8_t rslt;
+	uint64_t tick;
+	uint64_t now_tick;
+	sl_sleeptimer_timestamp_t now;
+	uint32_t freq = sl_sleeptimer_get_timer_frequency();
+
+	rslt = bma400_clock_sync_to_tick(sync, sensortime, &tick);
+	if ((rslt == BMA400_OK) && (time != NULL)) {
+		/* Age of the sample against the current time */
+		now = sl_sleeptimer_get_time();
+		now_tick = sl_sleeptimer_get_tick_count64();
+		if (now_tick >= tick) {
+			*time = now - (sl_sleeptimer_timestamp_t) (((now_tick - tick)
+					+ (freq / 2)) / freq);
+		} else {
+			*time = now + (sl_sleeptimer_timestamp_t) (((tick - now_tick)
+					+ (freq / 2)) / freq);
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+#endif
+
+int8_t bma400_set_fifo_compact(uint8_t enable, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t n_written;
+	uint8_t header;
+	uint8_t frame_len;
+	uint16_t watermark;
+	struct bma400_device_conf conf;
+
+	/* Get the current FIFO configuration */
+	conf.type = BMA400_FIFO_CONF;
+	rslt = bma400_get_device_conf(&conf, 1, dev);
+	if (rslt == BMA400_OK) {
+		/* FIFO_CONFIG0 is written back with only the width changed */
+		conf.param.fifo_conf.conf_status = BMA400_ENABLE;
+		conf.param.fifo_conf.conf_regs = BMA400_SET_BITS(
+				conf.param.fifo_conf.conf_regs, BMA400_FIFO_8_BIT_EN,
+				(enable == BMA400_ENABLE));
+
+		/* Frame length of the new width, the 8 bit frames carry no
+		 * width flag in their header
+		 */
+		header = BMA400_FIFO_EMPTY_FRAME
+				| (BMA400_GET_BITS(conf.param.fifo_conf.conf_regs,
+						BMA400_FIFO_AXES_EN) << 1);
+		frame_len = 1 + fifo_payload_len(
+				(enable == BMA400_ENABLE) ? 0 : BMA400_12_BIT_FIFO_DATA,
+				header);
+		if (header == BMA400_FIFO_EMPTY_FRAME) {
+			/* No axis in the FIFO */
+			rslt = BMA400_E_INVALID_CONFIG;
+		}
+	}
+	if (rslt == BMA400_OK) {
+		/* The watermark keeps its fill level in bytes, so each
+		 * interrupt carries more of the shorter frames. It is
+		 * aligned to whole frames.
+		 */
+		watermark = conf.param.fifo_conf.fifo_watermark;
+		watermark = (watermark / frame_len) * frame_len;
+		if (watermark < frame_len) {
+			watermark = frame_len;
+		}
+		conf.param.fifo_conf.fifo_watermark = watermark;
+		rslt = bma400_apply_conf(NULL, 0, &conf, 1, &n_written, dev);
+	}
+
+	return rslt;
+}
+
+int8_t bma400_fifo_stream_reset(struct bma400_fifo_stream *stream) {
+	int8_t rslt = BMA400_OK;
+
+	if (stream != NULL) {
+		/* Drop the bytes of a split frame */
+		stream->carry_len = 0;
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_extract_accel_stream(struct bma400_fifo_stream *stream,
+		struct bma400_fifo_data *fifo, struct bma400_sensor_data *accel_data,
+		uint16_t *frame_count, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t header;
+	uint8_t frame_len;
+	uint16_t data_start;
+	uint16_t copy_len;
+	uint16_t accel_index = 0;
+	uint16_t n_frames;
+	uint16_t partial_idx;
+	struct bma400_fifo_data carry_fifo;
+	struct accel_out out;
 
 	/* Check for null pointer in the device structure */
 	rslt = null_ptr_check(dev);
 
-	/* Proceed if null check is fine */
-	if (rslt == BMA400_OK) {
-		/* Parse the FIFO data */
-		unpack_accel_frame(fifo, accel_data, frame_count, dev);
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (stream != NULL) && (fifo != NULL)
+			&& (accel_data != NULL)) {
+		out.x = (uint8_t *) accel_data
+				+ offsetof(struct bma400_sensor_data, x);
+		out.y = (uint8_t *) accel_data
+				+ offsetof(struct bma400_sensor_data, y);
+		out.z = (uint8_t *) accel_data
+				+ offsetof(struct bma400_sensor_data, z);
+		out.stride = sizeof(struct bma400_sensor_data);
+		data_start = BMA400_FIFO_HEADROOM + dev->dummy_byte;
+		if (fifo->accel_byte_start_idx == 0) {
+			fifo->accel_byte_start_idx = data_start;
+		}
+
+		/* The split frame is completed from the start of a new read */
+		if ((stream->carry_len > 0) && (*frame_count > 0)
+				&& (fifo->accel_byte_start_idx == data_start)) {
+			header = stream->carry[1];
+			frame_len = 1 + fifo_payload_len(
+					BMA400_GET_BITS(header, BMA400_FIFO_8_BIT_EN),
+					header & BMA400_AWIDTH_MASK);
+			copy_len = frame_len - stream->carry_len;
+			if (copy_len > (fifo->length - data_start)) {
+				copy_len = fifo->length - data_start;
+			}
+			memcpy(&stream->carry[1 + stream->carry_len], &fifo->data[data_start],
+					copy_len);
+			stream->carry_len += copy_len;
+			fifo->accel_byte_start_idx += copy_len;
+			if (stream->carry_len == frame_len) {
+				/* Parse the completed frame on its own */
+				carry_fifo = *fifo;
+				carry_fifo.data = stream->carry;
+				carry_fifo.length = 1 + frame_len;
+				carry_fifo.accel_byte_start_idx = 1;
+				n_frames = 1;
+				unpack_accel_frame(&carry_fifo, &out, &n_frames, NULL, dev);
+				fifo->conf_change = carry_fifo.conf_change;
+				fifo->fifo_sensor_time = carry_fifo.fifo_sensor_time;
+				fifo->fifo_sensor_time_avail =
+						carry_fifo.fifo_sensor_time_avail;
+				accel_index = n_frames;
+				stream->carry_len = 0;
+			}
+		}
+
+		/* Parse the rest of the read */
+		n_frames = *frame_count - accel_index;
+		partial_idx = fifo->length;
+		out.x = (uint8_t *) &accel_data[accel_index]
+				+ offsetof(struct bma400_sensor_data, x);
+		out.y = (uint8_t *) &accel_data[accel_index]
+				+ offsetof(struct bma400_sensor_data, y);
+		out.z = (uint8_t *) &accel_data[accel_index]
+				+ offsetof(struct bma400_sensor_data, z);
+		if ((n_frames > 0) && (fifo->accel_byte_start_idx < fifo->length)) {
+			unpack_accel_frame(fifo, &out, &n_frames, &partial_idx, dev);
+		} else {
+			n_frames = 0;
+		}
+		if (partial_idx < fifo->length) {
+			/* Keep the frame cut by the end of the read */
+			stream->carry_len = fifo->length - partial_idx;
+			memcpy(&stream->carry[1], &fifo->data[partial_idx],
+					stream->carry_len);
+		}
+		*frame_count = accel_index + n_frames;
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
 	}
 
 	return rslt;
@@ -1494,6 +3904,7 @@ int8_t bma400_perform_self_test(const struct bma400_dev *dev) {
 	int8_t rslt;
 	int8_t self_test_rslt = 0;
 	struct bma400_sensor_data accel_pos, accel_neg;
+	struct bma400_self_test_result result;
 
 	/* Check for null pointer in the device structure */
 	rslt = null_ptr_check(dev);
@@ -1508,7 +3919,8 @@ int8_t bma400_perform_self_test(const struct bma400_dev *dev) {
 				rslt = negative_excited_accel(&accel_neg, dev);
 				if (rslt == BMA400_OK) {
 					/* Validate the self test result */
-					rslt = validate_accel_self_test(&accel_pos, &accel_neg);
+					rslt = validate_accel_self_test(&accel_pos, &accel_neg,
+							&result);
 				}
 			}
 		}
@@ -1532,6 +3944,266 @@ int8_t bma400_perform_self_test(const struct bma400_dev *dev) {
 	return rslt;
 }
 
+int8_t bma400_self_test_start(struct bma400_self_test *st,
+		bma400_bringup_cb_t notify, void *cb_ctx, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t reg_data[3];
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (st != NULL)) {
+		if (st->state != BMA400_SELF_TEST_IDLE) {
+			rslt = BMA400_E_BUSY;
+		} else {
+			/* Kept to be written back instead of a soft reset */
+			rslt = bma400_get_regs(BMA400_ACCEL_CONFIG_0_ADDR, st->saved_conf,
+					3, dev);
+		}
+		if (rslt == BMA400_OK) {
+			/* Normal mode, 100Hz, 4g, OSR 3 on the filter 1 data */
+			memcpy(reg_data, st->saved_conf, 3);
+			reg_data[0] = BMA400_SET_BITS_POS_0(reg_data[0], BMA400_POWER_MODE,
+					BMA400_NORMAL_MODE);
+			reg_data[1] = BMA400_SET_BITS(reg_data[1], BMA400_ACCEL_RANGE,
+					BMA400_4G_RANGE);
+			reg_data[1] = BMA400_SET_BITS(reg_data[1], BMA400_OSR,
+					BMA400_ACCEL_OSR_SETTING_3);
+			reg_data[1] = BMA400_SET_BITS_POS_0(reg_data[1], BMA400_ACCEL_ODR,
+					BMA400_ODR_100HZ);
+			reg_data[2] = BMA400_SET_BITS(reg_data[2], BMA400_DATA_FILTER,
+					BMA400_DATA_SRC_ACCEL_FILT_1);
+			rslt = bma400_set_regs(BMA400_ACCEL_CONFIG_0_ADDR, reg_data, 3, dev);
+		}
+		if (rslt == BMA400_OK) {
+			st->dev = dev;
+			st->notify = notify;
+			st->cb_ctx = cb_ctx;
+			st->state = BMA400_SELF_TEST_SETTLE;
+			rslt = self_test_wait(st, BMA400_SELF_TEST_ENABLE_MS);
+			if (rslt != BMA400_W_IN_PROGRESS) {
+				(void) self_test_restore(st);
+				st->state = BMA400_SELF_TEST_IDLE;
+			}
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_self_test_process(struct bma400_self_test *st) {
+	int8_t rslt = BMA400_OK;
+
+	if (st == NULL) {
+		rslt = BMA400_E_NULL_PTR;
+	} else if (st->state != BMA400_SELF_TEST_IDLE) {
+		if (st->pending) {
+			st->pending = FALSE;
+			rslt = self_test_step(st);
+		} else {
+			rslt = BMA400_W_IN_PROGRESS;
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_self_test_abort(struct bma400_self_test *st) {
+	int8_t rslt = BMA400_OK;
+
+	if (st != NULL) {
+		if (st->state != BMA400_SELF_TEST_IDLE) {
+			(void) sl_sleeptimer_stop_timer(&st->timer);
+			st->state = BMA400_SELF_TEST_IDLE;
+			st->pending = FALSE;
+			rslt = self_test_restore(st);
+		}
+	} else {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_calib_capture(uint8_t orientation, uint8_t n_samples,
+		struct bma400_calib_session *session, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t reg_data = 0;
+	uint8_t range = 0;
+	uint8_t odr;
+	uint8_t axis;
+	uint8_t count;
+	int16_t value[3];
+	int16_t min[3] = { 0, 0, 0 };
+	int16_t max[3] = { 0, 0, 0 };
+	int32_t sum[3] = { 0, 0, 0 };
+	int32_t mean;
+	int32_t max_spread;
+	struct bma400_sensor_data accel;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (session != NULL)) {
+		if ((orientation > BMA400_CALIB_Z_DOWN) || (n_samples == 0)) {
+			rslt = BMA400_E_INVALID_CONFIG;
+		} else {
+			rslt = bma400_get_regs(BMA400_ACCEL_CONFIG_1_ADDR, &reg_data, 1,
+					dev);
+		}
+		if (rslt == BMA400_OK) {
+			range = BMA400_GET_BITS(reg_data, BMA400_ACCEL_RANGE);
+			if ((session->captured != 0) && (range != session->range)) {
+				/* The captures of one solve share the range */
+				rslt = BMA400_E_INVALID_CONFIG;
+			}
+		}
+
+		/* A new sample each output data period, 80 ms at 12.5 Hz */
+		odr = BMA400_GET_BITS_POS_0(reg_data, BMA400_ACCEL_ODR);
+		if (odr < BMA400_ODR_12_5HZ) {
+			odr = BMA400_ODR_12_5HZ;
+		} else if (odr > BMA400_ODR_800HZ) {
+			odr = BMA400_ODR_800HZ;
+		}
+		for (count = 0; (count < n_samples) && (rslt == BMA400_OK); count++) {
+			delay((80 >> (odr - BMA400_ODR_12_5HZ)) + 1);
+			rslt = bma400_get_accel_data(BMA400_DATA_ONLY, &accel, dev);
+			value[0] = accel.x;
+			value[1] = accel.y;
+			value[2] = accel.z;
+			for (axis = 0; (axis < 3) && (rslt == BMA400_OK); axis++) {
+				sum[axis] += value[axis];
+				if ((count == 0) || (value[axis] < min[axis])) {
+					min[axis] = value[axis];
+				}
+				if ((count == 0) || (value[axis] > max[axis])) {
+					max[axis] = value[axis];
+				}
+			}
+		}
+		if (rslt == BMA400_OK) {
+			/* A capture that moved is not kept */
+			max_spread = ((int32_t) BMA400_CALIB_MAX_SPREAD_MG * 128)
+					/ lsb_to_mg_q7[range];
+			for (axis = 0; axis < 3; axis++) {
+				if ((max[axis] - min[axis]) > max_spread) {
+					rslt = BMA400_W_CALIB_REJECTED;
+				}
+			}
+
+			/* Nor one whose vertical axis is not at least 0.5 g in the
+			 * direction of the orientation
+			 */
+			axis = orientation >> 1;
+			mean = (sum[axis] * 16) / n_samples;
+			if ((((orientation & 1) == 0) ? mean : -mean)
+					< (((int32_t) 1024 >> range) * 8)) {
+				rslt = BMA400_W_CALIB_REJECTED;
+			}
+		}
+		if (rslt == BMA400_OK) {
+			session->mean[orientation] = mean;
+			session->range = range;
+			session->captured |= 1 << orientation;
+		}
+	} else if (rslt == BMA400_OK) {
+		rslt = BMA400_E_NULL_PTR;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_calib_solve(const struct bma400_calib_session *session,
+		struct bma400_calib *calib) {
+	int8_t rslt = BMA400_OK;
+	uint8_t axis;
+	int32_t up;
+	int32_t down;
+	int32_t two_g;
+
+	if ((session == NULL) || (calib == NULL)) {
+		rslt = BMA400_E_NULL_PTR;
+	} else if (session->captured != BMA400_CALIB_ALL_CAPTURED) {
+		rslt = BMA400_E_INVALID_CONFIG;
+	} else {
+		/* 2 g in 12-bit LSB, Q4 */
+		two_g = ((int32_t) 2048 >> session->range) * 16;
+		calib->version = BMA400_CALIB_VERSION;
+		calib->range = session->range;
+		for (axis = 0; axis < 3; axis++) {
+			/* The captures keep up above and down below 0.5 g, so the
+			 * span between them is at least 1 g
+			 */
+			up = session->mean[2 * axis];
+			down = session->mean[(2 * axis) + 1];
+
+			/* The offset is midway between up and down, the gain maps the
+			 * span between them on 2 g
+			 */
+			calib->offset[axis] = (int16_t) ((up + down) / 2);
+			calib->gain[axis] = (uint16_t) (((two_g << 14)
+					+ ((up - down) / 2)) / (up - down));
+		}
+		calib->check = calib_check(calib);
+		if (calib_in_limits(calib) == FALSE) {
+			rslt = BMA400_W_CALIB_REJECTED;
+		}
+	}
+
+	return rslt;
+}
+
+int8_t bma400_calib_check(const struct bma400_calib *calib) {
+	int8_t rslt = BMA400_OK;
+
+	if (calib == NULL) {
+		rslt = BMA400_E_NULL_PTR;
+	} else if ((calib->version != BMA400_CALIB_VERSION)
+			|| (calib->check != calib_check(calib))
+			|| (calib_in_limits(calib) == FALSE)) {
+		rslt = BMA400_E_INVALID_CONFIG;
+	}
+
+	return rslt;
+}
+
+int8_t bma400_set_calib(const struct bma400_calib *calib,
+		struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t reg_data;
+
+	/* Check for null pointer in the device structure */
+	rslt = null_ptr_check(dev);
+
+	/* Proceed if null check is fine */
+	if ((rslt == BMA400_OK) && (calib != NULL)) {
+		rslt = bma400_calib_check(calib);
+		if (rslt == BMA400_OK) {
+			rslt = bma400_get_regs(BMA400_ACCEL_CONFIG_1_ADDR, &reg_data, 1,
+					dev);
+		}
+		if ((rslt == BMA400_OK)
+				&& (BMA400_GET_BITS(reg_data, BMA400_ACCEL_RANGE)
+						!= calib->range)) {
+			/* The coefficients only hold at the range they were solved */
+			rslt = BMA400_E_INVALID_CONFIG;
+		}
+		if (rslt == BMA400_OK) {
+			dev->calib = calib;
+		}
+	} else if (rslt == BMA400_OK) {
+		/* Back to the raw data */
+		dev->calib = NULL;
+	}
+
+	return rslt;
+}
+
 /*****************************INTERNAL APIs***********************************************/
 static int8_t null_ptr_check(const struct bma400_dev *dev) {
 	int8_t rslt;
@@ -1548,6 +4220,22 @@ static int8_t null_ptr_check(const struct bma400_dev *dev) {
 	return rslt;
 }
 
+static void pack_accel_conf(uint8_t *data_array,
+		const struct bma400_acc_conf *accel_conf) {
+	data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_FILT_1_BW,
+			accel_conf->filt1_bw);
+	data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_OSR_LP,
+			accel_conf->osr_lp);
+	data_array[1] = BMA400_SET_BITS(data_array[1], BMA400_ACCEL_RANGE,
+			accel_conf->range);
+	data_array[1] = BMA400_SET_BITS(data_array[1], BMA400_OSR,
+			accel_conf->osr);
+	data_array[1] = BMA400_SET_BITS_POS_0(data_array[1], BMA400_ACCEL_ODR,
+			accel_conf->odr);
+	data_array[2] = BMA400_SET_BITS(data_array[2], BMA400_DATA_FILTER,
+			accel_conf->data_src);
+}
+
 static int8_t set_accel_conf(const struct bma400_acc_conf *accel_conf,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
@@ -1558,18 +4246,7 @@ static int8_t set_accel_conf(const struct bma400_acc_conf *accel_conf,
 	 */
 	rslt = bma400_get_regs(BMA400_ACCEL_CONFIG_0_ADDR, data_array, 3, dev);
 	if (rslt == BMA400_OK) {
-		data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_FILT_1_BW,
-				accel_conf->filt1_bw);
-		data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_OSR_LP,
-				accel_conf->osr_lp);
-		data_array[1] = BMA400_SET_BITS(data_array[1], BMA400_ACCEL_RANGE,
-				accel_conf->range);
-		data_array[1] = BMA400_SET_BITS(data_array[1], BMA400_OSR,
-				accel_conf->osr);
-		data_array[1] = BMA400_SET_BITS_POS_0(data_array[1], BMA400_ACCEL_ODR,
-				accel_conf->odr);
-		data_array[2] = BMA400_SET_BITS(data_array[2], BMA400_DATA_FILTER,
-				accel_conf->data_src);
+		pack_accel_conf(data_array, accel_conf);
 
 		/* Set the accel configurations in the sensor */
 		rslt = bma400_set_regs(BMA400_ACCEL_CONFIG_0_ADDR, data_array, 3, dev);
@@ -1602,11 +4279,6 @@ static int8_t get_accel_data(uint8_t data_sel, struct bma400_sensor_data *accel,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
 	uint8_t data_array[9] = { 0 };
-	uint16_t lsb;
-	uint8_t msb;
-	uint8_t time_0;
-	uint16_t time_1;
-	uint32_t time_2;
 
 	if (data_sel == BMA400_DATA_ONLY) {
 		/* Read the sensor data registers only */
@@ -1619,47 +4291,58 @@ static int8_t get_accel_data(uint8_t data_sel, struct bma400_sensor_data *accel,
 		rslt = BMA400_E_INVALID_CONFIG;
 	}
 	if (rslt == BMA400_OK) {
-		lsb = data_array[0];
-		msb = data_array[1];
+		unpack_sensor_data(data_array, data_sel, accel);
+	}
 
-		/* accel X axis data */
-		accel->x = (int16_t) (((uint16_t) msb * 256) + lsb);
-		if (accel->x > 2047) {
-			/* Computing accel data negative value */
-			accel->x = accel->x - 4096;
-		}
-		lsb = data_array[2];
-		msb = data_array[3];
+	return rslt;
+}
 
-		/* accel Y axis data */
-		accel->y = (int16_t) (((uint16_t) msb * 256) | lsb);
-		if (accel->y > 2047) {
-			/* Computing accel data negative value */
-			accel->y = accel->y - 4096;
-		}
-		lsb = data_array[4];
-		msb = data_array[5];
+static void unpack_sensor_data(const uint8_t *data_array, uint8_t data_sel,
+		struct bma400_sensor_data *accel) {
+	uint16_t lsb;
+	uint8_t msb;
+	uint8_t time_0;
+	uint16_t time_1;
+	uint32_t time_2;
 
-		/* accel Z axis data */
-		accel->z = (int16_t) (((uint16_t) msb * 256) | lsb);
-		if (accel->z > 2047) {
-			/* Computing accel data negative value */
-			accel->z = accel->z - 4096;
-		}
-		if (data_sel == BMA400_DATA_ONLY) {
-			/* Update sensortime as 0 */
-			accel->sensortime = 0;
-		}
-		if (data_sel == BMA400_DATA_SENSOR_TIME) {
-			/* Sensor-time data*/
-			time_0 = data_array[6];
-			time_1 = ((uint16_t) data_array[7] << 8);
-			time_2 = ((uint32_t) data_array[8] << 16);
-			accel->sensortime = (uint32_t) (time_2 + time_1 + time_0);
-		}
-	}
+	lsb = data_array[0];
+	msb = data_array[1];
 
-	return rslt;
+	/* accel X axis data */
+	accel->x = (int16_t) (((uint16_t) msb * 256) + lsb);
+	if (accel->x > 2047) {
+		/* Computing accel data negative value */
+		accel->x = accel->x - 4096;
+	}
+	lsb = data_array[2];
+	msb = data_array[3];
+
+	/* accel Y axis data */
+	accel->y = (int16_t) (((uint16_t) msb * 256) | lsb);
+	if (accel->y > 2047) {
+		/* Computing accel data negative value */
+		accel->y = accel->y - 4096;
+	}
+	lsb = data_array[4];
+	msb = data_array[5];
+
+	/* accel Z axis data */
+	accel->z = (int16_t) (((uint16_t) msb * 256) | lsb);
+	if (accel->z > 2047) {
+		/* Computing accel data negative value */
+		accel->z = accel->z - 4096;
+	}
+	if (data_sel == BMA400_DATA_ONLY) {
+		/* Update sensortime as 0 */
+		accel->sensortime = 0;
+	}
+	if (data_sel == BMA400_DATA_SENSOR_TIME) {
+		/* Sensor-time data*/
+		time_0 = data_array[6];
+		time_1 = ((uint16_t) data_array[7] << 8);
+		time_2 = ((uint32_t) data_array[8] << 16);
+		accel->sensortime = (uint32_t) (time_2 + time_1 + time_0);
+	}
 }
 
 static int8_t set_autowakeup_timeout(
@@ -1869,6 +4552,29 @@ static int8_t get_auto_low_power(struct bma400_auto_lp_conf *auto_lp_conf,
 	return rslt;
 }
 
+static void pack_tap_conf(uint8_t *reg_data,
+		const struct bma400_tap_conf *tap_set) {
+	/* Set the axis to sense for tap */
+	reg_data[0] = BMA400_SET_BITS(reg_data[0], BMA400_TAP_AXES_EN,
+			tap_set->axes_sel);
+
+	/* Set the threshold for tap sensing */
+	reg_data[0] = BMA400_SET_BITS_POS_0(reg_data[0], BMA400_TAP_SENSITIVITY,
+			tap_set->sensitivity);
+
+	/* Set the Quiet_dt setting */
+	reg_data[1] = BMA400_SET_BITS(reg_data[1], BMA400_TAP_QUIET_DT,
+			tap_set->quiet_dt);
+
+	/* Set the Quiet setting */
+	reg_data[1] = BMA400_SET_BITS(reg_data[1], BMA400_TAP_QUIET,
+			tap_set->quiet);
+
+	/* Set the tics_th setting */
+	reg_data[1] = BMA400_SET_BITS_POS_0(reg_data[1], BMA400_TAP_TICS_TH,
+			tap_set->tics_th);
+}
+
 static int8_t set_tap_conf(const struct bma400_tap_conf *tap_set,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
@@ -1876,25 +4582,7 @@ static int8_t set_tap_conf(const struct bma400_tap_conf *tap_set,
 
 	rslt = bma400_get_regs(BMA400_TAP_CONFIG_ADDR, reg_data, 2, dev);
 	if (rslt == BMA400_OK) {
-		/* Set the axis to sense for tap */
-		reg_data[0] = BMA400_SET_BITS(reg_data[0], BMA400_TAP_AXES_EN,
-				tap_set->axes_sel);
-
-		/* Set the threshold for tap sensing */
-		reg_data[0] = BMA400_SET_BITS_POS_0(reg_data[0], BMA400_TAP_SENSITIVITY,
-				tap_set->sensitivity);
-
-		/* Set the Quiet_dt setting */
-		reg_data[1] = BMA400_SET_BITS(reg_data[1], BMA400_TAP_QUIET_DT,
-				tap_set->quiet_dt);
-
-		/* Set the Quiet setting */
-		reg_data[1] = BMA400_SET_BITS(reg_data[1], BMA400_TAP_QUIET,
-				tap_set->quiet);
-
-		/* Set the tics_th setting */
-		reg_data[1] = BMA400_SET_BITS_POS_0(reg_data[1], BMA400_TAP_TICS_TH,
-				tap_set->tics_th);
+		pack_tap_conf(reg_data, tap_set);
 
 		/* Set the TAP configuration in the sensor*/
 		rslt = bma400_set_regs(BMA400_TAP_CONFIG_ADDR, reg_data, 2, dev);
@@ -1931,17 +4619,13 @@ static int8_t get_tap_conf(struct bma400_tap_conf *tap_set,
 	return rslt;
 }
 
-static int8_t set_activity_change_conf(
-		const struct bma400_act_ch_conf *act_ch_set,
-		const struct bma400_dev *dev) {
-	int8_t rslt;
-	uint8_t data_array[2] = { 0 };
-
+static void pack_activity_change_conf(uint8_t *data_array,
+		const struct bma400_act_ch_conf *act_ch_set) {
 	/* Set the activity change threshold */
 	data_array[0] = act_ch_set->act_ch_thres;
 
 	/* Set the axis to sense for activity change */
-	data_array[1] = BMA400_SET_BITS(data_array[1], BMA400_ACT_CH_AXES_EN,
+	data_array[1] = BMA400_SET_BITS(0, BMA400_ACT_CH_AXES_EN,
 			act_ch_set->axes_sel);
 
 	/* Set the data source for activity change */
@@ -1953,6 +4637,15 @@ static int8_t set_activity_change_conf(
 	 */
 	data_array[1] = BMA400_SET_BITS_POS_0(data_array[1], BMA400_ACT_CH_NPTS,
 			act_ch_set->act_ch_ntps);
+}
+
+static int8_t set_activity_change_conf(
+		const struct bma400_act_ch_conf *act_ch_set,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t data_array[2] = { 0 };
+
+	pack_activity_change_conf(data_array, act_ch_set);
 
 	/* Set the Activity change configuration in the sensor*/
 	rslt = bma400_set_regs(BMA400_ACT_CH_CONFIG_0_ADDR, data_array, 2, dev);
@@ -1988,13 +4681,12 @@ static int8_t get_activity_change_conf(struct bma400_act_ch_conf *act_ch_set,
 	return rslt;
 }
 
-static int8_t set_gen1_int(const struct bma400_gen_int_conf *gen_int_set,
-		const struct bma400_dev *dev) {
-	int8_t rslt;
-	uint8_t data_array[11] = { 0 };
+static uint8_t pack_gen_int(uint8_t *data_array,
+		const struct bma400_gen_int_conf *gen_int_set) {
+	uint8_t len = 5;
 
 	/* Set the axes to sense for interrupt */
-	data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_INT_AXES_EN,
+	data_array[0] = BMA400_SET_BITS(0, BMA400_INT_AXES_EN,
 			gen_int_set->axes_sel);
 
 	/* Set the data source for interrupt */
@@ -2012,7 +4704,7 @@ static int8_t set_gen1_int(const struct bma400_gen_int_conf *gen_int_set,
 	/* Set the criterion to generate interrupt on either
 	 * ACTIVITY OR INACTIVITY
 	 */
-	data_array[1] = BMA400_SET_BITS(data_array[1], BMA400_GEN_INT_CRITERION,
+	data_array[1] = BMA400_SET_BITS(0, BMA400_GEN_INT_CRITERION,
 			gen_int_set->criterion_sel);
 
 	/* Set the interrupt axes logic (AND/OR) for the
@@ -2050,14 +4742,24 @@ static int8_t set_gen1_int(const struct bma400_gen_int_conf *gen_int_set,
 		/* Set the MSB of reference z threshold */
 		data_array[10] = BMA400_GET_MSB(gen_int_set->int_thres_ref_z);
 
-		/* Set the GEN1 INT configuration in the sensor */
-		rslt = bma400_set_regs(BMA400_GEN1_INT_CONFIG_ADDR, data_array, 11,
-				dev);
-	} else {
-		/* Set the GEN1 INT configuration in the sensor */
-		rslt = bma400_set_regs(BMA400_GEN1_INT_CONFIG_ADDR, data_array, 5, dev);
+		len = 11;
 	}
 
+	return len;
+}
+
+static int8_t set_gen1_int(const struct bma400_gen_int_conf *gen_int_set,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t len;
+	uint8_t data_array[11] = { 0 };
+
+	/* Reference values are only written for manual reference update */
+	len = pack_gen_int(data_array, gen_int_set);
+
+	/* Set the GEN1 INT configuration in the sensor */
+	rslt = bma400_set_regs(BMA400_GEN1_INT_CONFIG_ADDR, data_array, len, dev);
+
 	return rslt;
 }
 
@@ -2117,72 +4819,14 @@ static int8_t get_gen1_int(struct bma400_gen_int_conf *gen_int_set,
 static int8_t set_gen2_int(const struct bma400_gen_int_conf *gen_int_set,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
+	uint8_t len;
 	uint8_t data_array[11] = { 0 };
 
-	/* Set the axes to sense for interrupt */
-	data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_INT_AXES_EN,
-			gen_int_set->axes_sel);
-
-	/* Set the data source for interrupt */
-	data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_INT_DATA_SRC,
-			gen_int_set->data_src);
-
-	/* Set the reference update mode */
-	data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_INT_REFU,
-			gen_int_set->ref_update);
-
-	/* Set the hysteresis for interrupt calculation */
-	data_array[0] = BMA400_SET_BITS_POS_0(data_array[0], BMA400_INT_HYST,
-			gen_int_set->hysteresis);
-
-	/* Set the criterion to generate interrupt on either
-	 * ACTIVITY OR INACTIVITY
-	 */
-	data_array[1] = BMA400_SET_BITS(data_array[1], BMA400_GEN_INT_CRITERION,
-			gen_int_set->criterion_sel);
-
-	/* Set the interrupt axes logic (AND/OR) for the
-	 * enabled axes to generate interrupt
-	 */
-	data_array[1] = BMA400_SET_BITS_POS_0(data_array[1], BMA400_GEN_INT_COMB,
-			gen_int_set->evaluate_axes);
-
-	/* Set the interrupt threshold */
-	data_array[2] = gen_int_set->gen_int_thres;
-
-	/* Set the MSB of gen int dur */
-	data_array[3] = BMA400_GET_MSB(gen_int_set->gen_int_dur);
-
-	/* Set the LSB of gen int dur */
-	data_array[4] = BMA400_GET_LSB(gen_int_set->gen_int_dur);
-
-	/* Handling case of manual reference update */
-	if (gen_int_set->ref_update == BMA400_MANUAL_UPDATE) {
-		/* Set the LSB of reference x threshold */
-		data_array[5] = BMA400_GET_LSB(gen_int_set->int_thres_ref_x);
-
-		/* Set the MSB of reference x threshold */
-		data_array[6] = BMA400_GET_MSB(gen_int_set->int_thres_ref_x);
-
-		/* Set the LSB of reference y threshold */
-		data_array[7] = BMA400_GET_LSB(gen_int_set->int_thres_ref_y);
-
-		/* Set the MSB of reference y threshold */
-		data_array[8] = BMA400_GET_MSB(gen_int_set->int_thres_ref_y);
-
-		/* Set the LSB of reference z threshold */
-		data_array[9] = BMA400_GET_LSB(gen_int_set->int_thres_ref_z);
-
-		/* Set the MSB of reference z threshold */
-		data_array[10] = BMA400_GET_MSB(gen_int_set->int_thres_ref_z);
+	/* Reference values are only written for manual reference update */
+	len = pack_gen_int(data_array, gen_int_set);
 
-		/* Set the GEN2 INT configuration in the sensor */
-		rslt = bma400_set_regs(BMA400_GEN2_INT_CONFIG_ADDR, data_array, 11,
-				dev);
-	} else {
-		/* Set the GEN2 INT configuration in the sensor */
-		rslt = bma400_set_regs(BMA400_GEN2_INT_CONFIG_ADDR, data_array, 5, dev);
-	}
+	/* Set the GEN2 INT configuration in the sensor */
+	rslt = bma400_set_regs(BMA400_GEN2_INT_CONFIG_ADDR, data_array, len, dev);
 
 	return rslt;
 }
@@ -2238,15 +4882,14 @@ static int8_t get_gen2_int(struct bma400_gen_int_conf *gen_int_set,
 	}
 
 	return rslt;
-}
-
-static int8_t set_orient_int(const struct bma400_orient_int_conf *orient_conf,
-		const struct bma400_dev *dev) {
-	int8_t rslt;
-	uint8_t data_array[10] = { 0 };
+}
+
+static uint8_t pack_orient_int(uint8_t *data_array,
+		const struct bma400_orient_int_conf *orient_conf) {
+	uint8_t len = 4;
 
 	/* Set the axes to sense for interrupt */
-	data_array[0] = BMA400_SET_BITS(data_array[0], BMA400_INT_AXES_EN,
+	data_array[0] = BMA400_SET_BITS(0, BMA400_INT_AXES_EN,
 			orient_conf->axes_sel);
 
 	/* Set the data source for interrupt */
@@ -2290,17 +4933,27 @@ static int8_t set_orient_int(const struct bma400_orient_int_conf *orient_conf,
 		/* Set the LSB of reference z threshold */
 		data_array[9] = BMA400_GET_MSB(orient_conf->orient_ref_z);
 
-		/* Set the orient configurations in the sensor */
-		rslt = bma400_set_regs(BMA400_ORIENTCH_INT_CONFIG_ADDR, data_array, 10,
-				dev);
-	} else {
-		/* Set the orient configurations in the sensor excluding
-		 * reference values of x,y,z
-		 */
-		rslt = bma400_set_regs(BMA400_ORIENTCH_INT_CONFIG_ADDR, data_array, 4,
-				dev);
+		len = 10;
 	}
 
+	return len;
+}
+
+static int8_t set_orient_int(const struct bma400_orient_int_conf *orient_conf,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t len;
+	uint8_t data_array[10] = { 0 };
+
+	/* Reference values of x,y,z are only written for manual
+	 * reference update
+	 */
+	len = pack_orient_int(data_array, orient_conf);
+
+	/* Set the orient configurations in the sensor */
+	rslt = bma400_set_regs(BMA400_ORIENTCH_INT_CONFIG_ADDR, data_array, len,
+			dev);
+
 	return rslt;
 }
 
@@ -2770,6 +5423,20 @@ static void get_int_pin_map(const uint8_t *data_array, uint8_t int_enable,
 	}
 }
 
+static void pack_int_pin_conf(uint8_t *reg_data,
+		struct bma400_int_pin_conf int_conf) {
+	if (int_conf.int_chan == BMA400_INT_CHANNEL_1) {
+		/* Setting interrupt pin configurations */
+		*reg_data = BMA400_SET_BITS(*reg_data, BMA400_INT_PIN1_CONF,
+				int_conf.pin_conf);
+	}
+	if (int_conf.int_chan == BMA400_INT_CHANNEL_2) {
+		/* Setting interrupt pin configurations */
+		*reg_data = BMA400_SET_BITS(*reg_data, BMA400_INT_PIN2_CONF,
+				int_conf.pin_conf);
+	}
+}
+
 static int8_t set_int_pin_conf(struct bma400_int_pin_conf int_conf,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
@@ -2777,16 +5444,7 @@ static int8_t set_int_pin_conf(struct bma400_int_pin_conf int_conf,
 
 	rslt = bma400_get_regs(BMA400_INT_12_IO_CTRL_ADDR, &reg_data, 1, dev);
 	if (rslt == BMA400_OK) {
-		if (int_conf.int_chan == BMA400_INT_CHANNEL_1) {
-			/* Setting interrupt pin configurations */
-			reg_data = BMA400_SET_BITS(reg_data, BMA400_INT_PIN1_CONF,
-					int_conf.pin_conf);
-		}
-		if (int_conf.int_chan == BMA400_INT_CHANNEL_2) {
-			/* Setting interrupt pin configurations */
-			reg_data = BMA400_SET_BITS(reg_data, BMA400_INT_PIN2_CONF,
-					int_conf.pin_conf);
-		}
+		pack_int_pin_conf(&reg_data, int_conf);
 
 		/* Set the configurations in the sensor */
 		rslt = bma400_set_regs(BMA400_INT_12_IO_CTRL_ADDR, &reg_data, 1, dev);
@@ -2848,11 +5506,38 @@ static int8_t get_fifo_conf(struct bma400_fifo_conf *fifo_conf,
 	return rslt;
 }
 
+static uint8_t pack_fifo_conf(uint8_t *data_array,
+		const struct bma400_fifo_conf *fifo_conf) {
+	uint8_t len = 1;
+	uint8_t wm_lsb;
+	uint8_t wm_msb;
+
+	/* FIFO configurations */
+	if (fifo_conf->conf_status == BMA400_DISABLE) {
+		/* Disable the selected interrupt status */
+		data_array[0] = data_array[0] & (~fifo_conf->conf_regs);
+	} else {
+		data_array[0] = fifo_conf->conf_regs;
+	}
+
+	/* FIFO water-mark values */
+	wm_lsb = BMA400_GET_LSB(fifo_conf->fifo_watermark);
+	wm_msb = BMA400_GET_MSB(fifo_conf->fifo_watermark);
+	wm_msb = BMA400_GET_BITS_POS_0(wm_msb, BMA400_FIFO_BYTES_CNT);
+	if ((wm_lsb != data_array[1]) || (wm_msb != data_array[2])) {
+		data_array[1] = wm_lsb;
+		data_array[2] = wm_msb;
+		len = 3;
+	}
+
+	return len;
+}
+
 static int8_t set_fifo_conf(const struct bma400_fifo_conf *fifo_conf,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
+	uint8_t len;
 	uint8_t data_array[3];
-	uint8_t sens_data[3];
 
 	/* Check for null pointer in the device structure */
 	rslt = null_ptr_check(dev);
@@ -2862,32 +5547,14 @@ static int8_t set_fifo_conf(const struct bma400_fifo_conf *fifo_conf,
 		/* Get the FIFO configurations and water-mark
 		 * values from the sensor
 		 */
-		rslt = bma400_get_regs(BMA400_FIFO_CONFIG_0_ADDR, sens_data, 3, dev);
+		rslt = bma400_get_regs(BMA400_FIFO_CONFIG_0_ADDR, data_array, 3, dev);
 		if (rslt == BMA400_OK) {
-			/* FIFO configurations */
-			data_array[0] = fifo_conf->conf_regs;
-			if (fifo_conf->conf_status == BMA400_DISABLE) {
-				/* Disable the selected interrupt status */
-				data_array[0] = sens_data[0] & (~data_array[0]);
-			}
+			/* The watermark is only written when it changes */
+			len = pack_fifo_conf(data_array, fifo_conf);
 
-			/* FIFO water-mark values */
-			data_array[1] = BMA400_GET_LSB(fifo_conf->fifo_watermark);
-			data_array[2] = BMA400_GET_MSB(fifo_conf->fifo_watermark);
-			data_array[2] = BMA400_GET_BITS_POS_0(data_array[2],
-					BMA400_FIFO_BYTES_CNT);
-			if ((data_array[1] == sens_data[1])
-					&& (data_array[2] == sens_data[2])) {
-				/* Set the FIFO configurations in the
-				 * sensor excluding the watermark value
-				 */
-				rslt = bma400_set_regs(BMA400_FIFO_CONFIG_0_ADDR, data_array, 1,
-						dev);
-			} else {
-				/* Set the FIFO configurations in the sensor*/
-				rslt = bma400_set_regs(BMA400_FIFO_CONFIG_0_ADDR, data_array, 3,
-						dev);
-			}
+			/* Set the FIFO configurations in the sensor*/
+			rslt = bma400_set_regs(BMA400_FIFO_CONFIG_0_ADDR, data_array, len,
+					dev);
 		}
 	}
 
@@ -2916,6 +5583,7 @@ static int8_t read_fifo(const struct bma400_fifo_data *fifo,
 		const struct bma400_dev *dev) {
 	int8_t rslt;
 	uint8_t reg_data;
+	uint8_t was_disabled;
 	uint8_t fifo_addr = BMA400_FIFO_DATA_ADDR;
 
 	if (dev->intf == BMA400_SPI_INTF) {
@@ -2923,47 +5591,795 @@ static int8_t read_fifo(const struct bma400_fifo_data *fifo,
 		fifo_addr = fifo_addr | BMA400_SPI_RD_MASK;
 	}
 
-	/* Read the FIFO enable bit */
-	rslt = bma400_get_regs(BMA400_FIFO_READ_EN_ADDR, &reg_data, 1, dev);
-	if (rslt == BMA400_OK) {
-		/* FIFO read disable bit */
-		if (reg_data == 0) {
-			/* Read FIFO Buffer since FIFO read is enabled */
-			rslt = spi_read(dev->dev_id, fifo_addr, fifo->data, fifo->length);
-			if (rslt != 0) {
-				rslt = BMA400_E_COM_FAIL;
-			}
-		} else {
-			/* Enable FIFO reading */
-			reg_data = 0;
-			rslt = bma400_set_regs(BMA400_FIFO_READ_EN_ADDR, &reg_data, 1, dev);
-			if (rslt == BMA400_OK) {
-				/* Delay to enable the FIFO */
-				delay(1);
+	/* Enable FIFO reading if needed */
+	rslt = enable_fifo_read(&was_disabled, dev);
+	if (rslt == BMA400_OK) {
+		/* Read FIFO Buffer in place since FIFO read is enabled,
+		 * the address byte is sent from the start of the buffer
+		 */
+		rslt = dev->read(dev->intf_ptr, dev->dev_id, fifo_addr, &fifo->data[1],
+				fifo->length - 1);
+		if (rslt != 0) {
+			rslt = BMA400_E_COM_FAIL;
+		} else if (was_disabled == TRUE) {
+			/* Disable FIFO reading */
+			reg_data = 1;
+			rslt = bma400_set_regs(BMA400_FIFO_READ_EN_ADDR, &reg_data, 1,
+					dev);
+		}
+	}
+
+	return rslt;
+}
+
+static int8_t prepare_fifo_read(struct bma400_fifo_data *fifo,
+		uint16_t headroom, const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t data;
+	uint16_t fifo_byte_cnt = 0;
+	uint16_t user_fifo_len = 0;
+
+	if (fifo->length < headroom) {
+		/* No room left for the headroom */
+		return BMA400_E_INVALID_CONFIG;
+	}
+
+	/* Resetting the FIFO data byte index */
+	fifo->accel_byte_start_idx = 0;
+
+	/* Reading the FIFO length */
+	rslt = get_fifo_length(&fifo_byte_cnt, dev);
+	if (rslt == BMA400_OK) {
+		/* Get the FIFO configurations
+		 * from the sensor */
+		rslt = bma400_get_regs(BMA400_FIFO_CONFIG_0_ADDR, &data, 1, dev);
+		if (rslt == BMA400_OK) {
+			/* Get the data from FIFO_CONFIG0 register */
+			fifo->fifo_8_bit_en = BMA400_GET_BITS(data, BMA400_FIFO_8_BIT_EN);
+			fifo->fifo_data_enable = BMA400_GET_BITS(data,
+					BMA400_FIFO_AXES_EN);
+			fifo->fifo_time_enable = BMA400_GET_BITS(data,
+					BMA400_FIFO_TIME_EN);
+			fifo->fifo_sensor_time = 0;
+			fifo->fifo_sensor_time_avail = FALSE;
+			fifo->length = fifo->length - headroom;
+			user_fifo_len = fifo->length;
+			if (fifo->length > fifo_byte_cnt) {
+				/* Handling case where user requests
+				 * more data than available in FIFO
+				 */
+				fifo->length = fifo_byte_cnt;
+			}
+
+			/* Reading extra bytes as per the macro
+			 * "BMA400_FIFO_BYTES_OVERREAD"
+			 * when FIFO time is enabled
+			 */
+			if ((fifo->fifo_time_enable == BMA400_ENABLE)
+					&& (fifo_byte_cnt + BMA400_FIFO_BYTES_OVERREAD
+							<= user_fifo_len)) {
+				/* Handling sensor time availability*/
+				fifo->length = fifo->length + BMA400_FIFO_BYTES_OVERREAD;
+			}
+		}
+	}
+
+	return rslt;
+}
+
+static int8_t enable_fifo_read(uint8_t *was_disabled,
+		const struct bma400_dev *dev) {
+	int8_t rslt;
+	uint8_t reg_data;
+
+	*was_disabled = FALSE;
+
+	/* Read the FIFO enable bit */
+	rslt = bma400_get_regs(BMA400_FIFO_READ_EN_ADDR, &reg_data, 1, dev);
+	if ((rslt == BMA400_OK) && (reg_data != 0)) {
+		/* Enable FIFO reading */
+		reg_data = 0;
+		rslt = bma400_set_regs(BMA400_FIFO_READ_EN_ADDR, &reg_data, 1, dev);
+		if (rslt == BMA400_OK) {
+			/* Delay to enable the FIFO */
+			delay(1);
+			*was_disabled = TRUE;
+		}
+	}
+
+	return rslt;
+}
+
+static void fifo_async_done(int8_t rslt, struct bma400_spi_xfer *xfer,
+		void *cb_ctx) {
+	struct bma400_fifo_data *fifo = fifo_async.fifo;
+
+	(void) xfer;
+	(void) cb_ctx;
+
+	/* Parsing starts after the address and dummy bytes */
+	fifo->accel_byte_start_idx = fifo_async.start_idx;
+	fifo_async.busy = FALSE;
+	fifo_async.callback(rslt, fifo, fifo_async.cb_ctx);
+}
+
+static int fifo_acq_done(unsigned int channel, unsigned int sequence_no,
+		void *user_param) {
+	struct bma400_fifo_acq *acq = (struct bma400_fifo_acq *) user_param;
+	struct bma400_fifo_data *fifo = &acq->fifo[(sequence_no - 1) & 1];
+
+	(void) channel;
+	if (acq->running) {
+		/* Parsing starts after the unused address and dummy bytes,
+		 * the sensor time of the previous fill is not carried over
+		 */
+		fifo->accel_byte_start_idx = BMA400_FIFO_HEADROOM
+				+ acq->dev->dummy_byte;
+		fifo->fifo_sensor_time_avail = FALSE;
+		acq->callback(BMA400_OK, fifo, acq->cb_ctx);
+	}
+
+	return acq->running;
+}
+
+static void fifo_acq_release(const struct bma400_spi_dev *spi) {
+	SPIDRV_Handle_t handle = &spi->bus->handle;
+	USART_TypeDef *usart = handle->initData.port;
+
+	(void) DMADRV_StopTransfer(handle->rxDMACh);
+	(void) DMADRV_StopTransfer(handle->txDMACh);
+
+	/* Let the last byte shift out before the chip select goes high */
+	while ((usart->STATUS & USART_STATUS_TXC) == 0) {
+	}
+	usart->CMD = USART_CMD_CLEARRX;
+	spi_deselect(spi);
+	USART_BaudrateSyncSet(usart, 0, spi->bit_rate);
+	spi_bus_release(spi->bus);
+}
+
+static void fifo_wm_irq(uint8_t int_no) {
+	/* The FIFO is read from the application loop */
+	if ((int_no < BMA400_GPIO_INT_COUNT) && (fifo_wm_acq[int_no] != NULL)) {
+		fifo_wm_acq[int_no]->pending = TRUE;
+	}
+}
+
+static void dma_poll_irq(uint8_t int_no) {
+	if ((dma_poll != NULL) && (int_no == dma_poll->gpio_pin)) {
+		/* The edge woke the MCU up from EM2, which stops the LDMA
+		 * and the USART, so EM2 stays blocked until the frame is in
+		 */
+		SLEEP_SleepBlockBegin(sleepEM2);
+		dma_poll->in_flight++;
+		LDMA->SWREQ = 1UL << dma_poll->trig_ch;
+	}
+}
+
+static int8_t dma_poll_arm(struct bma400_dma_poll *poll,
+		const struct bma400_spi_dev *spi) {
+	SPIDRV_Handle_t handle = &spi->bus->handle;
+	USART_TypeDef *usart = handle->initData.port;
+	LDMA_TransferCfg_t trig_cfg = LDMA_TRANSFER_CFG_MEMORY();
+	LDMA_TransferCfg_t tx_cfg =
+			LDMA_TRANSFER_CFG_PERIPHERAL(handle->txDMASignal);
+	LDMA_TransferCfg_t rx_cfg =
+			LDMA_TRANSFER_CFG_PERIPHERAL(handle->rxDMASignal);
+	LDMA_Descriptor_t *rx_desc = poll->rx_desc;
+	uint32_t dout;
+	uint32_t cs_set;
+	uint32_t cs_clr;
+	uint32_t cs_mask = 1UL << spi->cs_pin;
+	uint8_t n_slots = 2 * poll->batch;
+	uint8_t n_rx = 0;
+	uint8_t idx;
+	Ecode_t ecode;
+	CORE_DECLARE_IRQ_STATE;
+
+	/* Bit rate of the device, the chip select is left to the LDMA */
+	spi_select(spi);
+	spi_deselect(spi);
+	usart->CMD = USART_CMD_CLEARRX;
+
+	dout = (uint32_t) &GPIO->P[spi->cs_port].DOUT;
+	cs_set = PER_BITSET_MEM_BASE + (dout - PER_MEM_BASE);
+	cs_clr = PER_BITCLR_MEM_BASE + (dout - PER_MEM_BASE);
+
+	/* Burst read from ACC_X_LSB to the sensor time, zeros after the
+	 * address
+	 */
+	memset(poll->cmd, 0, sizeof(poll->cmd));
+	poll->cmd[0] = BMA400_ACCEL_DATA_ADDR | BMA400_SPI_RD_MASK;
+
+	/* Each software request selects the device and releases the TX
+	 * chain
+	 */
+	poll->trig_desc[0] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_WRITE(
+			cs_mask, cs_clr, 1);
+	poll->trig_desc[0].wri.structReq = 0;
+	poll->trig_desc[1] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_SYNC(
+			BMA400_DMA_POLL_SYNC_MSK, 0, 0, 0, -1);
+
+	/* One command per release, the bit is cleared before it goes out
+	 * so the next wait blocks
+	 */
+	poll->tx_desc[0] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_SYNC(0, 0,
+			BMA400_DMA_POLL_SYNC_MSK, BMA400_DMA_POLL_SYNC_MSK, 1);
+	poll->tx_desc[1] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_SYNC(0,
+			BMA400_DMA_POLL_SYNC_MSK, 0, 0, 1);
+	poll->tx_desc[2] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(
+			poll->cmd, &usart->TXDATA, BMA400_DMA_POLL_FRAME_LEN, -2);
+	poll->tx_desc[2].xfer.doneIfs = 0;
+
+	/* A frame per slot of the ring, the chip select goes high once its
+	 * last byte is received. The interrupt then lifts the EM2 block.
+	 */
+	for (idx = 0; idx < n_slots; idx++) {
+		rx_desc[n_rx] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(
+				&usart->RXDATA, poll->frames[idx], BMA400_DMA_POLL_FRAME_LEN,
+				1);
+		rx_desc[n_rx++].xfer.doneIfs = 0;
+		rx_desc[n_rx++] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_WRITE(
+				cs_mask, cs_set, ((idx + 1) < n_slots) ? 1 : (1 - 2 * n_slots));
+		rx_desc[n_rx - 1].wri.doneIfs = 1;
+	}
+
+	BUS_RegMaskedClear(&LDMA->SYNC, BMA400_DMA_POLL_SYNC_MSK);
+	ecode = DMADRV_LdmaStartTransfer(handle->rxDMACh, &rx_cfg, rx_desc,
+			dma_poll_done, poll);
+	if (ecode == ECODE_EMDRV_DMADRV_OK) {
+		ecode = DMADRV_LdmaStartTransfer(handle->txDMACh, &tx_cfg,
+				poll->tx_desc, NULL, NULL);
+	}
+	if (ecode == ECODE_EMDRV_DMADRV_OK) {
+		ecode = DMADRV_LdmaStartTransfer(poll->trig_ch, &trig_cfg,
+				poll->trig_desc, NULL, NULL);
+	}
+	if (ecode == ECODE_EMDRV_DMADRV_OK) {
+		/* GPIO interrupts wake the MCU up from EM2, the rising edges
+		 * release the chains
+		 */
+		GPIO_PinModeSet((GPIO_Port_TypeDef) poll->gpio_port, poll->gpio_pin,
+				gpioModeInput, 0);
+		GPIOINT_CallbackRegister(poll->gpio_pin, dma_poll_irq);
+		GPIO_ExtIntConfig((GPIO_Port_TypeDef) poll->gpio_port,
+				poll->gpio_pin, poll->gpio_pin, true, false, true);
+
+		/* A sample may have come before the interrupt was enabled,
+		 * its pin then stays high without an edge
+		 */
+		CORE_ENTER_ATOMIC();
+		if (GPIO_PinInGet((GPIO_Port_TypeDef) poll->gpio_port,
+				poll->gpio_pin)) {
+			GPIO_IntClear(1UL << poll->gpio_pin);
+			dma_poll_irq(poll->gpio_pin);
+		}
+		CORE_EXIT_ATOMIC();
+	}
+
+	return (ecode == ECODE_EMDRV_DMADRV_OK) ? BMA400_OK : BMA400_E_COM_FAIL;
+}
+
+static int dma_poll_done(unsigned int channel, unsigned int sequence_no,
+		void *user_param) {
+	struct bma400_dma_poll *poll = (struct bma400_dma_poll *) user_param;
+	uint8_t mask;
+
+	(void) channel;
+	if (poll->in_flight > 0) {
+		poll->in_flight--;
+		SLEEP_SleepBlockEnd(sleepEM2);
+	}
+
+	/* The application is only woken up at the end of each batch */
+	if ((sequence_no % poll->batch) == 0) {
+		mask = 1 << (((sequence_no / poll->batch) - 1) & 1);
+		if (poll->filled & mask) {
+			/* Overwritten before being read */
+			poll->overruns++;
+		}
+		poll->filled |= mask;
+	}
+
+	return poll->running;
+}
+
+static void dma_poll_release(struct bma400_dma_poll *poll) {
+	const struct bma400_spi_dev *spi =
+			(const struct bma400_spi_dev *) poll->dev->intf_ptr;
+	SPIDRV_Handle_t handle = &spi->bus->handle;
+	USART_TypeDef *usart = handle->initData.port;
+
+	/* No more requests, then the chains are stopped wherever they are */
+	GPIO_ExtIntConfig((GPIO_Port_TypeDef) poll->gpio_port, poll->gpio_pin,
+			poll->gpio_pin, true, false, false);
+	GPIOINT_CallbackUnRegister(poll->gpio_pin);
+	(void) DMADRV_StopTransfer(poll->trig_ch);
+	(void) DMADRV_StopTransfer(handle->rxDMACh);
+	(void) DMADRV_StopTransfer(handle->txDMACh);
+	(void) DMADRV_FreeChannel(poll->trig_ch);
+	BUS_RegMaskedClear(&LDMA->SYNC, BMA400_DMA_POLL_SYNC_MSK);
+
+	/* A frame cut short is dropped by the sensor */
+	while ((usart->STATUS & USART_STATUS_TXC) == 0) {
+	}
+	usart->CMD = USART_CMD_CLEARRX;
+	spi_deselect(spi);
+
+	/* A frame cut short never reached its callback */
+	while (poll->in_flight > 0) {
+		poll->in_flight--;
+		SLEEP_SleepBlockEnd(sleepEM2);
+	}
+	poll->running = FALSE;
+	dma_poll = NULL;
+	spi_bus_release(spi->bus);
+}
+
+static void spi_select(const struct bma400_spi_dev *spi) {
+	struct bma400_spi_bus *bus = spi->bus;
+
+	/* Devices sharing a bus may run at different bit rates */
+	if (bus->active != spi) {
+		USART_BaudrateSyncSet(bus->handle.initData.port, 0, spi->bit_rate);
+		bus->active = spi;
+	}
+	GPIO_PinOutClear((GPIO_Port_TypeDef) spi->cs_port, spi->cs_pin);
+}
+
+static void spi_deselect(const struct bma400_spi_dev *spi) {
+	GPIO_PinOutSet((GPIO_Port_TypeDef) spi->cs_port, spi->cs_pin);
+}
+
+static uint8_t spi_bus_claim(struct bma400_spi_bus *bus,
+		struct bma400_spi_xfer *xfer) {
+	uint8_t claimed = FALSE;
+	CORE_DECLARE_IRQ_STATE;
+
+	CORE_ENTER_ATOMIC();
+	if ((bus->current == NULL) && (bus->queue == NULL)) {
+		bus->current = xfer;
+		spi_xfer_count++;
+		claimed = TRUE;
+	}
+	CORE_EXIT_ATOMIC();
+
+	return claimed;
+}
+
+static void spi_bus_release(struct bma400_spi_bus *bus) {
+	CORE_DECLARE_IRQ_STATE;
+
+	CORE_ENTER_ATOMIC();
+	bus->current = NULL;
+	spi_xfer_count--;
+	CORE_EXIT_ATOMIC();
+
+	/* Transactions submitted meanwhile waited in the queue */
+	spi_queue_next(bus);
+}
+
+static void spi_queue_next(struct bma400_spi_bus *bus) {
+	struct bma400_spi_xfer *xfer;
+	int8_t rslt;
+	Ecode_t ecode;
+	CORE_DECLARE_IRQ_STATE;
+
+	do {
+		CORE_ENTER_ATOMIC();
+		xfer = NULL;
+		if ((bus->current == NULL) && (bus->queue != NULL)) {
+			xfer = bus->queue;
+			bus->queue = xfer->next;
+			bus->current = xfer;
+		}
+		CORE_EXIT_ATOMIC();
+		if (xfer == NULL) {
+			break;
+		}
+
+		spi_select(xfer->spi);
+		if (xfer->n_segs != 0) {
+			rslt = spi_sg_start(bus, xfer);
+		} else {
+			if (xfer->tx_data == NULL) {
+				ecode = SPIDRV_MReceive(&bus->handle, xfer->rx_data,
+						xfer->length, spi_queue_done);
+			} else if (xfer->rx_data == NULL) {
+				ecode = SPIDRV_MTransmit(&bus->handle, xfer->tx_data,
+						xfer->length, spi_queue_done);
+			} else {
+				ecode = SPIDRV_MTransfer(&bus->handle, xfer->tx_data,
+						xfer->rx_data, xfer->length, spi_queue_done);
+			}
+			rslt = (ecode == ECODE_EMDRV_SPIDRV_OK) ?
+					BMA400_OK : BMA400_E_COM_FAIL;
+		}
+		if (rslt != BMA400_OK) {
+			/* Failed to start, the next one gets the bus */
+			spi_deselect(xfer->spi);
+			spi_xfer_complete(bus, xfer, BMA400_E_COM_FAIL);
+		}
+	} while (bus->current == NULL);
+}
+
+static void spi_xfer_complete(struct bma400_spi_bus *bus,
+		struct bma400_spi_xfer *xfer, int8_t rslt) {
+	CORE_DECLARE_IRQ_STATE;
+
+	CORE_ENTER_ATOMIC();
+	bus->current = NULL;
+	xfer->busy = FALSE;
+	spi_xfer_count--;
+	CORE_EXIT_ATOMIC();
+
+	/* The callback may submit the transaction again */
+	if (xfer->callback != NULL) {
+		xfer->callback(rslt, xfer, xfer->cb_ctx);
+	}
+}
+
+static void spi_queue_done(SPIDRV_Handle_t handle, Ecode_t transfer_status,
+		int items_transferred) {
+	struct bma400_spi_bus *bus = (struct bma400_spi_bus *) handle;
+	struct bma400_spi_xfer *xfer = bus->current;
+	int8_t rslt = BMA400_OK;
+
+	spi_deselect(xfer->spi);
+	if ((transfer_status != ECODE_EMDRV_SPIDRV_OK)
+			|| (items_transferred != xfer->length)) {
+		rslt = BMA400_E_COM_FAIL;
+	}
+	trace(BMA400_TRACE_SPI_QUEUED, (uint8_t) rslt, xfer->length,
+			xfer->priority);
+	spi_xfer_complete(bus, xfer, rslt);
+	spi_queue_next(bus);
+}
+
+static int8_t spi_sg_start(struct bma400_spi_bus *bus,
+		const struct bma400_spi_xfer *xfer) {
+	SPIDRV_Handle_t handle = &bus->handle;
+	USART_TypeDef *usart = handle->initData.port;
+	LDMA_TransferCfg_t tx_cfg =
+			LDMA_TRANSFER_CFG_PERIPHERAL(handle->txDMASignal);
+	LDMA_TransferCfg_t rx_cfg =
+			LDMA_TRANSFER_CFG_PERIPHERAL(handle->rxDMASignal);
+	LDMA_Descriptor_t *tx_desc = bus->sg_tx_desc;
+	LDMA_Descriptor_t *rx_desc = bus->sg_rx_desc;
+	const struct bma400_spi_seg *seg;
+	uint32_t dout;
+	uint32_t cs_set;
+	uint32_t cs_clr;
+	uint32_t cs_mask = 1UL << xfer->spi->cs_pin;
+	uint8_t n_tx = 0;
+	uint8_t n_rx = 0;
+	uint8_t idx;
+	uint8_t sync;
+	Ecode_t ecode;
+
+	/* The chip select is driven by the LDMA through the bit set and
+	 * clear aliases of DOUT
+	 */
+	dout = (uint32_t) &GPIO->P[xfer->spi->cs_port].DOUT;
+	cs_set = PER_BITSET_MEM_BASE + (dout - PER_MEM_BASE);
+	cs_clr = PER_BITCLR_MEM_BASE + (dout - PER_MEM_BASE);
+
+	for (idx = 0; idx < xfer->n_segs; idx++) {
+		seg = &xfer->segs[idx];
+
+		/* Value of the SYNC bit once the segment is complete */
+		sync = ((idx & 1) == 0) ? BMA400_SPI_SG_SYNC_MSK : 0;
+
+		tx_desc[n_tx] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(
+				(seg->tx_data != NULL) ? seg->tx_data : &spi_sg_tx_zero,
+				&usart->TXDATA, seg->length, 1);
+		if (seg->tx_data == NULL) {
+			tx_desc[n_tx].xfer.srcInc = ldmaCtrlSrcIncNone;
+		}
+		tx_desc[n_tx++].xfer.doneIfs = 0;
+
+		rx_desc[n_rx] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_P2M_BYTE(
+				&usart->RXDATA,
+				(seg->rx_data != NULL) ? seg->rx_data : &spi_sg_rx_sink,
+				seg->length, 1);
+		if (seg->rx_data == NULL) {
+			rx_desc[n_rx].xfer.dstInc = ldmaCtrlDstIncNone;
+		}
+		rx_desc[n_rx++].xfer.doneIfs = 0;
+
+		/* The last byte is received once it has been clocked, so the
+		 * frame can end
+		 */
+		rx_desc[n_rx++] = (LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_WRITE(
+				cs_mask, cs_set, 1);
+		if ((idx + 1) < xfer->n_segs) {
+			/* Next frame, then the TX chain is released */
+			rx_desc[n_rx++] =
+					(LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_WRITE(cs_mask,
+							cs_clr, 1);
+			rx_desc[n_rx++] =
+					(LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_SYNC(sync,
+							sync ^ BMA400_SPI_SG_SYNC_MSK, 0, 0, 1);
+			tx_desc[n_tx++] =
+					(LDMA_Descriptor_t) LDMA_DESCRIPTOR_LINKREL_SYNC(0, 0, sync,
+							BMA400_SPI_SG_SYNC_MSK, 1);
+		}
+	}
+
+	/* Only the end of the RX chain raises an interrupt */
+	tx_desc[n_tx - 1].xfer.link = 0;
+	rx_desc[n_rx - 1].xfer.link = 0;
+	rx_desc[n_rx - 1].xfer.doneIfs = 1;
+
+	BUS_RegMaskedClear(&LDMA->SYNC, BMA400_SPI_SG_SYNC_MSK);
+	ecode = DMADRV_LdmaStartTransfer(handle->rxDMACh, &rx_cfg, rx_desc,
+			spi_sg_done, bus);
+	if (ecode == ECODE_EMDRV_DMADRV_OK) {
+		ecode = DMADRV_LdmaStartTransfer(handle->txDMACh, &tx_cfg, tx_desc,
+				NULL, NULL);
+		if (ecode != ECODE_EMDRV_DMADRV_OK) {
+			(void) DMADRV_StopTransfer(handle->rxDMACh);
+		}
+	}
+
+	return (ecode == ECODE_EMDRV_DMADRV_OK) ? BMA400_OK : BMA400_E_COM_FAIL;
+}
+
+static int spi_sg_done(unsigned int channel, unsigned int sequence_no,
+		void *user_param) {
+	struct bma400_spi_bus *bus = (struct bma400_spi_bus *) user_param;
+	struct bma400_spi_xfer *xfer = bus->current;
+	uint16_t length = 0;
+	uint8_t idx;
+
+	(void) channel;
+	(void) sequence_no;
+	for (idx = 0; idx < xfer->n_segs; idx++) {
+		length += xfer->segs[idx].length;
+	}
+	trace(BMA400_TRACE_SPI_QUEUED, BMA400_OK, length, xfer->priority);
+	spi_xfer_complete(bus, xfer, BMA400_OK);
+	spi_queue_next(bus);
+
+	return 0;
+}
+
+static void spi_sync_done(int8_t rslt, struct bma400_spi_xfer *xfer,
+		void *cb_ctx) {
+	(void) xfer;
+	*(volatile int8_t *) cb_ctx = rslt;
+}
+
+static int8_t spi_xfer_sync(const struct bma400_spi_dev *spi, uint8_t *buffer,
+		uint16_t length, uint8_t receive) {
+	int8_t rslt;
+	volatile int8_t xfer_rslt = BMA400_E_COM_FAIL;
+	Ecode_t ecode;
+	struct bma400_spi_xfer xfer;
+
+	xfer.spi = spi;
+	xfer.tx_data = buffer;
+	xfer.rx_data = receive ? buffer : NULL;
+	xfer.length = length;
+	xfer.segs = NULL;
+	xfer.n_segs = 0;
+	xfer.priority = BMA400_SPI_PRIO_URGENT;
+	xfer.callback = spi_sync_done;
+	xfer.cb_ctx = (void *) &xfer_rslt;
+	xfer.next = NULL;
+	xfer.busy = FALSE;
+
+	if ((spi->bus->current == &fifo_acq_xfer)
+			|| (spi->bus->current == &dma_poll_xfer)) {
+		/* Held until the acquisition or the polling is stopped */
+		rslt = BMA400_E_BUSY;
+	} else if (spi_bus_claim(spi->bus, &xfer)) {
+		/* Idle bus: the blocking SPIDRV calls need no interrupt, so
+		 * this also works with interrupts masked or in a handler
+		 */
+		spi_select(spi);
+		if (receive) {
+			ecode = SPIDRV_MTransferB(&spi->bus->handle, buffer, buffer,
+					length);
+		} else {
+			ecode = SPIDRV_MTransmitB(&spi->bus->handle, buffer, length);
+		}
+		spi_deselect(spi);
+		spi_bus_release(spi->bus);
+		rslt = (ecode == ECODE_EMDRV_SPIDRV_OK) ?
+				BMA400_OK : BMA400_E_COM_FAIL;
+	} else if (CORE_IrqIsBlocked(LDMA_IRQn) || (__get_IPSR() != 0)) {
+		/* The wait below ends in the LDMA interrupt of the transfer in
+		 * progress, which could never run
+		 */
+		rslt = BMA400_E_BUSY;
+	} else {
+		/* Behind the transfer in progress, ahead of bulk ones */
+		rslt = bma400_spi_submit(&xfer);
+		if (rslt == BMA400_OK) {
+			while (xfer.busy) {
+			}
+			rslt = xfer_rslt;
+		}
+	}
+
+	return rslt;
+}
+
+static void trace(uint8_t event, uint8_t arg8, uint16_t arg16,
+		uint32_t arg32) {
+	struct bma400_trace_rec *slot;
+	uint32_t head;
+	uint32_t dropped;
+
+	/* The slot is reserved with an exclusive access, a writer preempting
+	 * another one takes the next slot
+	 */
+	do {
+		slot = NULL;
+		head = __LDREXW(&trace_ring.head);
+		if ((head - trace_ring.tail) >= BMA400_TRACE_LEN) {
+			__CLREX();
+			break;
+		}
+		slot = &trace_ring.rec[head & (BMA400_TRACE_LEN - 1)];
+	} while (__STREXW(head + 1, &trace_ring.head) != 0);
+
+	if (slot != NULL) {
+		slot->timestamp = sl_sleeptimer_get_tick_count();
+		slot->arg32 = arg32;
+		slot->arg16 = arg16;
+		slot->arg8 = arg8;
+
+		/* The event commits the record to the reader */
+		__DMB();
+		slot->event = event;
+	} else {
+		do {
+			dropped = __LDREXW(&trace_ring.dropped);
+		} while (__STREXW(dropped + 1, &trace_ring.dropped) != 0);
+	}
+}
+
+static uint32_t cycle_count(void) {
+	/* The cycle counter only runs with trace enabled */
+	if ((DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk) == 0) {
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	}
+
+	return DWT->CYCCNT;
+}
+
+static void delay_timer_cb(sl_sleeptimer_timer_handle_t *handle, void *data) {
+	(void) handle;
+	*(volatile uint8_t *) data = TRUE;
+}
+
+static void bringup_timer_cb(sl_sleeptimer_timer_handle_t *handle,
+		void *data) {
+	struct bma400_bringup *bu = (struct bma400_bringup *) data;
+
+	(void) handle;
+
+	/* The sensor is polled from the application loop */
+	bu->pending = TRUE;
+	if (bu->notify != NULL) {
+		bu->notify(bu->cb_ctx);
+	}
+}
+
+static int8_t bringup_start(struct bma400_bringup *bu, uint8_t state,
+		uint8_t settle_ms, uint8_t timeout_ms) {
+	int8_t rslt;
+
+	bu->state = state;
+	bu->pending = FALSE;
+	bu->deadline = sl_sleeptimer_get_tick_count()
+			+ sl_sleeptimer_ms_to_tick(timeout_ms);
+
+	if (settle_ms == 0) {
+		rslt = bringup_poll(bu);
+	} else if (sl_sleeptimer_start_timer_ms(&bu->timer, settle_ms,
+			bringup_timer_cb, bu, 0, 0) == SL_STATUS_OK) {
+		rslt = BMA400_W_IN_PROGRESS;
+	} else {
+		bu->state = BMA400_BRINGUP_IDLE;
+		rslt = BMA400_E_COM_FAIL;
+	}
+
+	return rslt;
+}
+
+static int8_t bringup_poll(struct bma400_bringup *bu) {
+	int8_t rslt = BMA400_OK;
+	uint8_t reg_data = 0;
+	uint8_t ready = FALSE;
+	uint8_t expired;
+
+	/* Sampled before the poll, so the sensor gets the full timeout */
+	expired = ((int32_t) (sl_sleeptimer_get_tick_count() - bu->deadline)
+			>= 0) ? TRUE : FALSE;
+
+	if (bu->state == BMA400_BRINGUP_POWER_MODE) {
+		rslt = bma400_get_power_mode(&reg_data, bu->dev);
+		if ((rslt == BMA400_OK) && (reg_data == bu->power_mode)) {
+			ready = TRUE;
+		} else if (expired) {
+			/* Auto low power or auto wakeup may already have moved
+			 * on, the switch is then as complete as a fixed delay
+			 */
+			ready = TRUE;
+		}
+	} else {
+		if (bu->dev->intf == BMA400_SPI_INTF) {
+			/* Dummy read, the sensor starts in I2C mode after power
+			 * up and soft reset. Polls of a soft reset only begin
+			 * once it took effect, so this read is what switches
+			 * the sensor back to SPI
+			 */
+			rslt = bma400_get_regs(0x7F, &reg_data, 1, bu->dev);
+		}
+		if (rslt == BMA400_OK) {
+			rslt = bma400_get_regs(BMA400_CHIP_ID_ADDR, &reg_data, 1,
+					bu->dev);
+		}
+		if ((rslt == BMA400_OK) && (reg_data == BMA400_CHIP_ID)) {
+			bu->dev->chip_id = reg_data;
+			ready = TRUE;
+		} else if (expired) {
+			rslt = BMA400_E_DEV_NOT_FOUND;
+		}
+	}
+
+	if ((ready == FALSE) && (expired == FALSE)) {
+		/* Not there yet, a communication failure included */
+		if (sl_sleeptimer_start_timer_ms(&bu->timer, BMA400_BRINGUP_POLL_MS,
+				bringup_timer_cb, bu, 0, 0) == SL_STATUS_OK) {
+			rslt = BMA400_W_IN_PROGRESS;
+		} else {
+			rslt = BMA400_E_COM_FAIL;
+		}
+	}
+	if (rslt != BMA400_W_IN_PROGRESS) {
+		bu->state = BMA400_BRINGUP_IDLE;
+	}
+
+	return rslt;
+}
 
-				/* Read FIFO Buffer since FIFO read is enabled*/
-				rslt = spi_read(dev->dev_id, fifo_addr, fifo->data,
-						fifo->length);
+static uint64_t mul_q32(uint64_t delta, uint64_t rate) {
+	/* Split so that no product exceeds 64 bits */
+	return (delta * (rate >> 32)) + ((delta * (rate & 0xFFFFFFFF)) >> 32);
+}
 
-				if (rslt == BMA400_OK) {
-					/* Disable FIFO reading */
-					reg_data = 1;
-					rslt = bma400_set_regs(BMA400_FIFO_READ_EN_ADDR, &reg_data,
-							1, dev);
-				}
-			}
-		}
+static uint64_t clock_sync_tick(const struct bma400_clock_sync *sync,
+		uint64_t sensortime) {
+	uint64_t tick;
+
+	if (sensortime >= sync->ref_sensortime) {
+		tick = sync->ref_tick
+				+ mul_q32(sensortime - sync->ref_sensortime, sync->rate);
+	} else {
+		tick = sync->ref_tick
+				- mul_q32(sync->ref_sensortime - sensortime, sync->rate);
 	}
 
-	return rslt;
+	return tick;
 }
 
 static void unpack_accel_frame(struct bma400_fifo_data *fifo,
-		struct bma400_sensor_data *accel_data, uint16_t *frame_count,
-		const struct bma400_dev *dev) {
+		const struct accel_out *out, uint16_t *frame_count,
+		uint16_t *partial_idx, const struct bma400_dev *dev) {
 	/* Frame header information is stored */
 	uint8_t frame_header = 0;
 
+	/* Index of the header of the current frame */
+	uint16_t frame_idx;
+
+	/* Accel data of a frame taking the generic decode */
+	struct bma400_sensor_data frame_data;
+
 	/* Accel data width is stored */
 	uint8_t accel_width;
 
@@ -2976,15 +6392,33 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 	/* Variable to check frame availability */
 	uint8_t frame_available = BMA400_ENABLE;
 
+	/* Calibration applied while unpacking */
+	struct accel_calib cal;
+
+	accel_calib_load(&cal, dev->calib);
+
 	/* Check if this is the first iteration of data unpacking
-	 * if yes, then consider dummy byte on SPI
+	 * if yes, then consider address and dummy byte on SPI
 	 */
 	if (fifo->accel_byte_start_idx == 0) {
-		/* Dummy byte included */
-		fifo->accel_byte_start_idx = dev->dummy_byte;
+		/* Address and dummy byte included */
+		fifo->accel_byte_start_idx = BMA400_FIFO_HEADROOM + dev->dummy_byte;
 	}
 	for (data_index = fifo->accel_byte_start_idx; data_index < fifo->length;) {
+		/* Runs of 12 bit and 8 bit XYZ frames skip the generic
+		 * decode
+		 */
+		accel_index += unpack_xyz12_run(fifo, out, accel_index,
+				*frame_count - accel_index, &data_index, &cal);
+		accel_index += unpack_xyz8_run(fifo, out, accel_index,
+				*frame_count - accel_index, &data_index, &cal);
+		if ((*frame_count == accel_index) || (data_index >= fifo->length)) {
+			/* Frames read completely */
+			break;
+		}
+
 		/*Header byte is stored in the variable frame_header*/
+		frame_idx = data_index;
 		frame_header = fifo->data[data_index];
 
 		/* Store the Accel 8 bit or 12 bit mode */
@@ -3001,8 +6435,10 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 					BMA400_FIFO_XYZ_ENABLE, &data_index);
 			if (frame_available != BMA400_DISABLE) {
 				/* Extract and store accel xyz data */
-				unpack_accel(fifo, &accel_data[accel_index], &data_index,
+				unpack_accel(fifo, &frame_data, &data_index,
 						accel_width, frame_header);
+				store_accel(out, accel_index, &frame_data, frame_header,
+						&cal);
 				accel_index++;
 			}
 			break;
@@ -3011,8 +6447,10 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 					BMA400_FIFO_X_ENABLE, &data_index);
 			if (frame_available != BMA400_DISABLE) {
 				/* Extract and store accel x data */
-				unpack_accel(fifo, &accel_data[accel_index], &data_index,
+				unpack_accel(fifo, &frame_data, &data_index,
 						accel_width, frame_header);
+				store_accel(out, accel_index, &frame_data, frame_header,
+						&cal);
 				accel_index++;
 			}
 			break;
@@ -3021,8 +6459,10 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 					BMA400_FIFO_Y_ENABLE, &data_index);
 			if (frame_available != BMA400_DISABLE) {
 				/* Extract and store accel y data */
-				unpack_accel(fifo, &accel_data[accel_index], &data_index,
+				unpack_accel(fifo, &frame_data, &data_index,
 						accel_width, frame_header);
+				store_accel(out, accel_index, &frame_data, frame_header,
+						&cal);
 				accel_index++;
 			}
 			break;
@@ -3031,8 +6471,10 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 					BMA400_FIFO_Z_ENABLE, &data_index);
 			if (frame_available != BMA400_DISABLE) {
 				/* Extract and store accel z data */
-				unpack_accel(fifo, &accel_data[accel_index], &data_index,
+				unpack_accel(fifo, &frame_data, &data_index,
 						accel_width, frame_header);
+				store_accel(out, accel_index, &frame_data, frame_header,
+						&cal);
 				accel_index++;
 			}
 			break;
@@ -3041,8 +6483,10 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 					BMA400_FIFO_XY_ENABLE, &data_index);
 			if (frame_available != BMA400_DISABLE) {
 				/* Extract and store accel xy data */
-				unpack_accel(fifo, &accel_data[accel_index], &data_index,
+				unpack_accel(fifo, &frame_data, &data_index,
 						accel_width, frame_header);
+				store_accel(out, accel_index, &frame_data, frame_header,
+						&cal);
 				accel_index++;
 			}
 			break;
@@ -3051,8 +6495,10 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 					BMA400_FIFO_YZ_ENABLE, &data_index);
 			if (frame_available != BMA400_DISABLE) {
 				/* Extract and store accel yz data */
-				unpack_accel(fifo, &accel_data[accel_index], &data_index,
+				unpack_accel(fifo, &frame_data, &data_index,
 						accel_width, frame_header);
+				store_accel(out, accel_index, &frame_data, frame_header,
+						&cal);
 				accel_index++;
 			}
 			break;
@@ -3061,8 +6507,10 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 					BMA400_FIFO_YZ_ENABLE, &data_index);
 			if (frame_available != BMA400_DISABLE) {
 				/* Extract and store accel xz data */
-				unpack_accel(fifo, &accel_data[accel_index], &data_index,
+				unpack_accel(fifo, &frame_data, &data_index,
 						accel_width, frame_header);
+				store_accel(out, accel_index, &frame_data, frame_header,
+						&cal);
 				accel_index++;
 			}
 			break;
@@ -3075,9 +6523,14 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 			}
 			break;
 		case BMA400_FIFO_EMPTY_FRAME:
-
-			/* Update the data index as complete */
-			data_index = fifo->length;
+			check_frame_available(fifo, &frame_available, accel_width,
+					BMA400_FIFO_EMPTY_FRAME, &data_index);
+			if (frame_available != BMA400_DISABLE) {
+				/* Skip the empty frame, data may follow when the
+				 * FIFO is read continuously
+				 */
+				data_index++;
+			}
 			break;
 		case BMA400_FIFO_CONTROL_FRAME:
 			check_frame_available(fifo, &frame_available, accel_width,
@@ -3093,6 +6546,10 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 			data_index = fifo->length;
 			break;
 		}
+		if ((frame_available == BMA400_DISABLE) && (partial_idx != NULL)) {
+			/* Frame cut by the end of the data */
+			*partial_idx = frame_idx;
+		}
 		if (*frame_count == accel_index) {
 			/* Frames read completely*/
 			break;
@@ -3109,73 +6566,44 @@ static void unpack_accel_frame(struct bma400_fifo_data *fifo,
 static void check_frame_available(const struct bma400_fifo_data *fifo,
 		uint8_t *frame_available, uint8_t accel_width, uint8_t data_en,
 		uint16_t *data_index) {
+	/* Handling case of 12 bit/ 8 bit data available in FIFO */
+	if ((*data_index + fifo_payload_len(accel_width, data_en))
+			> fifo->length) {
+		/* Partial frame available */
+		*data_index = fifo->length;
+		*frame_available = BMA400_DISABLE;
+	}
+}
+
+static uint8_t fifo_payload_len(uint8_t accel_width, uint8_t data_en) {
+	uint8_t len = 0;
+
 	switch (data_en) {
 	case BMA400_FIFO_XYZ_ENABLE:
-
-		/* Handling case of 12 bit/ 8 bit data available in FIFO */
-		if (accel_width == BMA400_12_BIT_FIFO_DATA) {
-			if ((*data_index + 6) > fifo->length) {
-				/* Partial frame available */
-				*data_index = fifo->length;
-				*frame_available = BMA400_DISABLE;
-			}
-		} else if ((*data_index + 3) > fifo->length) {
-			/* Partial frame available */
-			*data_index = fifo->length;
-			*frame_available = BMA400_DISABLE;
-		}
+		len = (accel_width == BMA400_12_BIT_FIFO_DATA) ? 6 : 3;
 		break;
 	case BMA400_FIFO_X_ENABLE:
 	case BMA400_FIFO_Y_ENABLE:
 	case BMA400_FIFO_Z_ENABLE:
-
-		/* Handling case of 12 bit/ 8 bit data available in FIFO */
-		if (accel_width == BMA400_12_BIT_FIFO_DATA) {
-			if ((*data_index + 2) > fifo->length) {
-				/* Partial frame available */
-				*data_index = fifo->length;
-				*frame_available = BMA400_DISABLE;
-			}
-		} else if ((*data_index + 1) > fifo->length) {
-			/* Partial frame available */
-			*data_index = fifo->length;
-			*frame_available = BMA400_DISABLE;
-		}
+		len = (accel_width == BMA400_12_BIT_FIFO_DATA) ? 2 : 1;
 		break;
 	case BMA400_FIFO_XY_ENABLE:
 	case BMA400_FIFO_YZ_ENABLE:
 	case BMA400_FIFO_XZ_ENABLE:
-
-		/* Handling case of 12 bit/ 8 bit data available in FIFO */
-		if (accel_width == BMA400_12_BIT_FIFO_DATA) {
-			if ((*data_index + 4) > fifo->length) {
-				/* Partial frame available */
-				*data_index = fifo->length;
-				*frame_available = BMA400_DISABLE;
-			}
-		} else if ((*data_index + 2) > fifo->length) {
-			/* Partial frame available */
-			*data_index = fifo->length;
-			*frame_available = BMA400_DISABLE;
-		}
+		len = (accel_width == BMA400_12_BIT_FIFO_DATA) ? 4 : 2;
 		break;
 	case BMA400_FIFO_SENSOR_TIME:
-		if ((*data_index + 3) > fifo->length) {
-			/* Partial frame available */
-			*data_index = fifo->length;
-			*frame_available = BMA400_DISABLE;
-		}
+		len = 3;
 		break;
 	case BMA400_FIFO_CONTROL_FRAME:
-		if ((*data_index + 1) > fifo->length) {
-			/* Partial frame available */
-			*data_index = fifo->length;
-			*frame_available = BMA400_DISABLE;
-		}
+	case BMA400_FIFO_EMPTY_FRAME:
+		len = 1;
 		break;
 	default:
 		break;
 	}
+
+	return len;
 }
 
 static void unpack_accel(const struct bma400_fifo_data *fifo,
@@ -3266,6 +6694,187 @@ static void unpack_accel(const struct bma400_fifo_data *fifo,
 	}
 }
 
+static uint16_t unpack_xyz12_run(const struct bma400_fifo_data *fifo,
+		const struct accel_out *out, uint16_t out_index, uint16_t max_frames,
+		uint16_t *data_index, const struct accel_calib *cal) {
+	const uint8_t *frame = &fifo->data[*data_index];
+	uint8_t *x = out->x + ((uint32_t) out_index * out->stride);
+	uint8_t *y = out->y + ((uint32_t) out_index * out->stride);
+	uint8_t *z = out->z + ((uint32_t) out_index * out->stride);
+	uint16_t stride = out->stride;
+	uint16_t n_frames;
+	uint16_t count;
+	int32_t raw;
+
+	/* Only complete frames are unpacked, so the bound is checked once */
+	n_frames = (fifo->length - *data_index) / BMA400_FIFO_XYZ_12BIT_FRAME_LEN;
+	if (n_frames > max_frames) {
+		n_frames = max_frames;
+	}
+	for (count = 0; count < n_frames; count++) {
+		if (frame[0] != BMA400_FIFO_XYZ_12BIT_HEADER) {
+			break;
+		}
+
+		/* The 12 bit value is placed in the top of a 16 bit word and
+		 * shifted back, the arithmetic shift extends the sign. The
+		 * calibration is a multiply-add on the way out
+		 */
+		raw = (int16_t) (((uint16_t) frame[2] << 8)
+				| ((uint16_t) (frame[1] & 0x0F) << 4)) >> 4;
+		*(int16_t *) x = (int16_t) (((raw * cal->mult[0]) + cal->add[0])
+				>> BMA400_CALIB_SHIFT);
+		raw = (int16_t) (((uint16_t) frame[4] << 8)
+				| ((uint16_t) (frame[3] & 0x0F) << 4)) >> 4;
+		*(int16_t *) y = (int16_t) (((raw * cal->mult[1]) + cal->add[1])
+				>> BMA400_CALIB_SHIFT);
+		raw = (int16_t) (((uint16_t) frame[6] << 8)
+				| ((uint16_t) (frame[5] & 0x0F) << 4)) >> 4;
+		*(int16_t *) z = (int16_t) (((raw * cal->mult[2]) + cal->add[2])
+				>> BMA400_CALIB_SHIFT);
+		frame += BMA400_FIFO_XYZ_12BIT_FRAME_LEN;
+		x += stride;
+		y += stride;
+		z += stride;
+	}
+	*data_index = *data_index + (count * BMA400_FIFO_XYZ_12BIT_FRAME_LEN);
+
+	return count;
+}
+
+static uint16_t unpack_xyz8_run(const struct bma400_fifo_data *fifo,
+		const struct accel_out *out, uint16_t out_index, uint16_t max_frames,
+		uint16_t *data_index, const struct accel_calib *cal) {
+	const uint8_t *frame = &fifo->data[*data_index];
+	uint8_t *x = out->x + ((uint32_t) out_index * out->stride);
+	uint8_t *y = out->y + ((uint32_t) out_index * out->stride);
+	uint8_t *z = out->z + ((uint32_t) out_index * out->stride);
+	uint16_t stride = out->stride;
+	uint16_t n_frames;
+	uint16_t count;
+	int32_t raw;
+
+	/* Only complete frames are unpacked, so the bound is checked once */
+	n_frames = (fifo->length - *data_index) / BMA400_FIFO_XYZ_8BIT_FRAME_LEN;
+	if (n_frames > max_frames) {
+		n_frames = max_frames;
+	}
+	for (count = 0; count < n_frames; count++) {
+		if (frame[0] != BMA400_FIFO_XYZ_8BIT_HEADER) {
+			break;
+		}
+
+		/* The 8 MSBs are sign extended and scaled to 12 bit, then
+		 * calibrated
+		 */
+		raw = (int32_t) ((int8_t) frame[1]) * 16;
+		*(int16_t *) x = (int16_t) (((raw * cal->mult[0]) + cal->add[0])
+				>> BMA400_CALIB_SHIFT);
+		raw = (int32_t) ((int8_t) frame[2]) * 16;
+		*(int16_t *) y = (int16_t) (((raw * cal->mult[1]) + cal->add[1])
+				>> BMA400_CALIB_SHIFT);
+		raw = (int32_t) ((int8_t) frame[3]) * 16;
+		*(int16_t *) z = (int16_t) (((raw * cal->mult[2]) + cal->add[2])
+				>> BMA400_CALIB_SHIFT);
+		frame += BMA400_FIFO_XYZ_8BIT_FRAME_LEN;
+		x += stride;
+		y += stride;
+		z += stride;
+	}
+	*data_index = *data_index + (count * BMA400_FIFO_XYZ_8BIT_FRAME_LEN);
+
+	return count;
+}
+
+static void store_accel(const struct accel_out *out, uint16_t out_index,
+		const struct bma400_sensor_data *frame_data, uint8_t frame_header,
+		const struct accel_calib *cal) {
+	uint32_t offset = (uint32_t) out_index * out->stride;
+	int16_t *x = (int16_t *) (out->x + offset);
+	int16_t *y = (int16_t *) (out->y + offset);
+	int16_t *z = (int16_t *) (out->z + offset);
+
+	/* Missing axes stay at zero rather than at the offset correction */
+	*x = frame_data->x;
+	*y = frame_data->y;
+	*z = frame_data->z;
+	if ((frame_header & BMA400_FIFO_X_ENABLE) == BMA400_FIFO_X_ENABLE) {
+		*x = (int16_t) ((((int32_t) frame_data->x * cal->mult[0])
+				+ cal->add[0]) >> BMA400_CALIB_SHIFT);
+	}
+	if ((frame_header & BMA400_FIFO_Y_ENABLE) == BMA400_FIFO_Y_ENABLE) {
+		*y = (int16_t) ((((int32_t) frame_data->y * cal->mult[1])
+				+ cal->add[1]) >> BMA400_CALIB_SHIFT);
+	}
+	if ((frame_header & BMA400_FIFO_Z_ENABLE) == BMA400_FIFO_Z_ENABLE) {
+		*z = (int16_t) ((((int32_t) frame_data->z * cal->mult[2])
+				+ cal->add[2]) >> BMA400_CALIB_SHIFT);
+	}
+}
+
+static void accel_calib_load(struct accel_calib *cal,
+		const struct bma400_calib *calib) {
+	uint8_t axis;
+
+	for (axis = 0; axis < 3; axis++) {
+		if (calib != NULL) {
+			/* (raw - offset) * gain, with the offset in Q4 and the
+			 * rounding folded into the constant term
+			 */
+			cal->mult[axis] = (int32_t) calib->gain[axis] * 16;
+			cal->add[axis] = ((int32_t) 1 << (BMA400_CALIB_SHIFT - 1))
+					- ((int32_t) calib->offset[axis] * calib->gain[axis]);
+		} else {
+			/* Unity gain, the rounding leaves the value as is */
+			cal->mult[axis] = (int32_t) BMA400_CALIB_GAIN_ONE * 16;
+			cal->add[axis] = (int32_t) 1 << (BMA400_CALIB_SHIFT - 1);
+		}
+	}
+}
+
+static uint16_t calib_check(const struct bma400_calib *calib) {
+	/* Seeded, so that a blank record does not check */
+	uint16_t check = 0xB400;
+	uint8_t axis;
+
+	check = (uint16_t) (((check << 1) | (check >> 15))
+			+ (calib->version | ((uint16_t) calib->range << 8)));
+	for (axis = 0; axis < 3; axis++) {
+		check = (uint16_t) (((check << 1) | (check >> 15))
+				+ (uint16_t) calib->offset[axis]);
+		check = (uint16_t) (((check << 1) | (check >> 15))
+				+ calib->gain[axis]);
+	}
+
+	return check;
+}
+
+static uint8_t calib_in_limits(const struct bma400_calib *calib) {
+	uint8_t in_limits = TRUE;
+	int32_t max_offset;
+	uint8_t axis;
+
+	if (calib->range > BMA400_16G_RANGE) {
+		in_limits = FALSE;
+	} else {
+		/* In 12-bit LSB Q4 at the range of the record */
+		max_offset = ((int32_t) BMA400_CALIB_MAX_OFFSET_MG * 128 * 16)
+				/ lsb_to_mg_q7[calib->range];
+		for (axis = 0; axis < 3; axis++) {
+			if ((calib->gain[axis]
+					< (BMA400_CALIB_GAIN_ONE - BMA400_CALIB_GAIN_TOL))
+					|| (calib->gain[axis]
+							> (BMA400_CALIB_GAIN_ONE + BMA400_CALIB_GAIN_TOL))
+					|| (calib->offset[axis] > max_offset)
+					|| (calib->offset[axis] < -max_offset)) {
+				in_limits = FALSE;
+			}
+		}
+	}
+
+	return in_limits;
+}
+
 static void unpack_sensortime_frame(struct bma400_fifo_data *fifo,
 		uint16_t *data_index) {
 	uint32_t time_msb;
@@ -3278,44 +6887,43 @@ static void unpack_sensortime_frame(struct bma400_fifo_data *fifo,
 
 	/* Sensor time */
 	fifo->fifo_sensor_time = (uint32_t) (time_msb | time_lsb | time_xlsb);
+	fifo->fifo_sensor_time_avail = TRUE;
 	*data_index = (*data_index) + 3;
 }
 
 static int8_t validate_accel_self_test(
 		const struct bma400_sensor_data *accel_pos,
-		const struct bma400_sensor_data *accel_neg) {
-
+		const struct bma400_sensor_data *accel_neg,
+		struct bma400_self_test_result *result) {
 	int8_t rslt;
-
-	/* Structure for difference of accel values in g */
-	struct selftest_delta_limit accel_data_diff = { 0, 0, 0 };
-
-	/* Structure for difference of accel values in mg */
-	struct selftest_delta_limit accel_data_diff_mg = { 0, 0, 0 };
-
-	accel_data_diff.x = accel_pos->x - accel_neg->x;
-	accel_data_diff.y = accel_pos->y - accel_neg->y;
-	accel_data_diff.z = accel_pos->z - accel_neg->z;
-
-	/* Converting LSB of the differences of accel
-	 * values to mg
-	 */
-	convert_lsb_g(&accel_data_diff, &accel_data_diff_mg);
-
-	/* Validate the results of self test
-	 * Self test value of x,y axes should be 800mg
-	 * and z axes should be 400 mg
+	int16_t diff[3];
+	int16_t diff_mg[3];
+	int32_t limit[3] = { BMA400_ST_ACC_X_AXIS_SIGNAL_DIFF,
+			BMA400_ST_ACC_Y_AXIS_SIGNAL_DIFF, BMA400_ST_ACC_Z_AXIS_SIGNAL_DIFF };
+	uint8_t idx;
+
+	diff[0] = accel_pos->x - accel_neg->x;
+	diff[1] = accel_pos->y - accel_neg->y;
+	diff[2] = accel_pos->z - accel_neg->z;
+
+	/* Range considered for self-test is 4g on 12-bit data */
+	(void) bma400_lsb_to_mg(diff, diff_mg, 3, BMA400_4G_RANGE,
+			BMA400_12_BIT_RESOLUTION);
+	result->x_mg = diff_mg[0];
+	result->y_mg = diff_mg[1];
+	result->z_mg = diff_mg[2];
+
+	/* Validate the results of self test against the limits in mg,
+	 * compared exactly in Q7 rather than after rounding
 	 */
-
-	if (((accel_data_diff_mg.x) > BMA400_ST_ACC_X_AXIS_SIGNAL_DIFF)
-			&& ((accel_data_diff_mg.y) > BMA400_ST_ACC_Y_AXIS_SIGNAL_DIFF)
-			&& ((accel_data_diff_mg.z) > BMA400_ST_ACC_Z_AXIS_SIGNAL_DIFF)) {
-
-		/*
-		 *   if (((accel_pos->x - accel_neg->x) > 205) && ((accel_pos->y - accel_neg->y) > 205) &&
-		 *          ((accel_pos->z - accel_neg->z) > 103))
-		 */
-
+	result->failed_axes = 0;
+	for (idx = 0; idx < 3; idx++) {
+		if (((int32_t) diff[idx] * lsb_to_mg_q7[BMA400_4G_RANGE])
+				<= (limit[idx] << 7)) {
+			result->failed_axes |= 1 << idx;
+		}
+	}
+	if (result->failed_axes == 0) {
 		/* Self test pass condition */
 		rslt = BMA400_OK;
 	} else {
@@ -3326,37 +6934,21 @@ static int8_t validate_accel_self_test(
 	return rslt;
 }
 
-static void convert_lsb_g(const struct selftest_delta_limit *accel_data_diff,
-		struct selftest_delta_limit *accel_data_diff_mg) {
-	uint32_t lsb_per_g;
-
-	/* Range considered for self-test is 4g */
-	uint8_t range = BMA400_4G_RANGE;
-
-	/* lsb_per_g for the respective resolution and 8g range*/
-	lsb_per_g = (uint32_t) (power(2, 8) / (2 * range));
-
-	/* accel x value in mg */
-	accel_data_diff_mg->x = (accel_data_diff->x / (int32_t) lsb_per_g) * 1000;
-
-	/* accel y value in mg */
-	accel_data_diff_mg->y = (accel_data_diff->y / (int32_t) lsb_per_g) * 1000;
-
-	/* accel z value in mg */
-	accel_data_diff_mg->z = (accel_data_diff->z / (int32_t) lsb_per_g) * 1000;
-}
-
-static int32_t power(int16_t base, uint8_t resolution) {
-	uint8_t i = 1;
-
-	/* Initialize variable to store the power of 2 value */
-	int32_t value = 1;
+static int8_t unit_conv_frac_bits(uint8_t resolution, uint8_t range,
+		uint8_t *frac_bits) {
+	int8_t rslt = BMA400_OK;
 
-	for (; i <= resolution; i++) {
-		value = (int32_t) (value * base);
+	if (range > BMA400_16G_RANGE) {
+		rslt = BMA400_E_INVALID_CONFIG;
+	} else if (resolution == BMA400_12_BIT_RESOLUTION) {
+		*frac_bits = 7;
+	} else if (resolution == BMA400_8_BIT_RESOLUTION) {
+		*frac_bits = 3;
+	} else {
+		rslt = BMA400_E_INVALID_CONFIG;
 	}
 
-	return value;
+	return rslt;
 }
 
 static int8_t positive_excited_accel(struct bma400_sensor_data *accel_pos,
@@ -3396,6 +6988,103 @@ static int8_t negative_excited_accel(struct bma400_sensor_data *accel_neg,
 	return rslt;
 }
 
+static void self_test_timer_cb(sl_sleeptimer_timer_handle_t *handle,
+		void *data) {
+	struct bma400_self_test *st = (struct bma400_self_test *) data;
+
+	(void) handle;
+
+	/* The sensor is accessed from the application loop */
+	st->pending = TRUE;
+	if (st->notify != NULL) {
+		st->notify(st->cb_ctx);
+	}
+}
+
+static int8_t self_test_wait(struct bma400_self_test *st, uint8_t ms) {
+	int8_t rslt;
+
+	st->pending = FALSE;
+	if (sl_sleeptimer_start_timer_ms(&st->timer, ms, self_test_timer_cb, st,
+			0, 0) == SL_STATUS_OK) {
+		rslt = BMA400_W_IN_PROGRESS;
+	} else {
+		rslt = BMA400_E_COM_FAIL;
+	}
+
+	return rslt;
+}
+
+static int8_t self_test_step(struct bma400_self_test *st) {
+	int8_t rslt;
+	int8_t restore_rslt;
+	uint8_t reg_data;
+	struct bma400_sensor_data accel_neg;
+
+	switch (st->state) {
+	case BMA400_SELF_TEST_SETTLE:
+
+		/* Enable positive excitation for all 3 axes */
+		reg_data = BMA400_ENABLE_POSITIVE_SELF_TEST;
+		rslt = bma400_set_regs(BMA400_SELF_TEST_ADDR, &reg_data, 1, st->dev);
+		if (rslt == BMA400_OK) {
+			st->state = BMA400_SELF_TEST_POSITIVE;
+			rslt = self_test_wait(st, BMA400_SELF_TEST_DATA_READ_MS);
+		}
+		break;
+	case BMA400_SELF_TEST_POSITIVE:
+		rslt = bma400_get_accel_data(BMA400_DATA_ONLY, &st->accel_pos,
+				st->dev);
+		if (rslt == BMA400_OK) {
+			/* Enable negative excitation for all 3 axes */
+			reg_data = BMA400_ENABLE_NEGATIVE_SELF_TEST;
+			rslt = bma400_set_regs(BMA400_SELF_TEST_ADDR, &reg_data, 1,
+					st->dev);
+		}
+		if (rslt == BMA400_OK) {
+			st->state = BMA400_SELF_TEST_NEGATIVE;
+			rslt = self_test_wait(st, BMA400_SELF_TEST_DATA_READ_MS);
+		}
+		break;
+	default:
+		rslt = bma400_get_accel_data(BMA400_DATA_ONLY, &accel_neg, st->dev);
+		if (rslt == BMA400_OK) {
+			rslt = validate_accel_self_test(&st->accel_pos, &accel_neg,
+					&st->result);
+		}
+		break;
+	}
+
+	if (rslt != BMA400_W_IN_PROGRESS) {
+		/* Done or failed, the configuration is put back either way */
+		st->state = BMA400_SELF_TEST_IDLE;
+		restore_rslt = self_test_restore(st);
+		if ((rslt >= BMA400_OK) && (restore_rslt != BMA400_OK)) {
+			rslt = restore_rslt;
+		}
+	}
+
+	return rslt;
+}
+
+static int8_t self_test_restore(const struct bma400_self_test *st) {
+	int8_t rslt;
+	uint8_t reg_data = BMA400_DISABLE_SELF_TEST;
+	struct bma400_reg_batch batch;
+
+	batch.n_regs = 0;
+	rslt = bma400_batch_add_regs(BMA400_SELF_TEST_ADDR, &reg_data, 1, &batch);
+	if (rslt == BMA400_OK) {
+		rslt = bma400_batch_add_regs(BMA400_ACCEL_CONFIG_0_ADDR,
+				st->saved_conf, 3, &batch);
+	}
+	if (rslt == BMA400_OK) {
+		rslt = bma400_batch_write(&batch, NULL, st->dev);
+	}
+
+	return rslt;
+}
+
 static int8_t enable_self_test(const struct bma400_dev *dev)
 {
     int8_t rslt;
@@ -3434,3 +7123,232 @@ static int8_t enable_self_test(const struct bma400_dev *dev)
 
     return rslt;
 }
+
+static int8_t write_reg_pairs(uint8_t *pairs, uint8_t n_regs,
+		const struct bma400_dev *dev) {
+	int8_t rslt = BMA400_OK;
+	uint8_t idx;
+
+	if (n_regs > 0) {
+		/* The first address is the command byte of the transaction,
+		 * the remaining data/address bytes follow as payload
+		 */
+		rslt = dev->write(dev->intf_ptr, dev->dev_id, pairs[0], &pairs[1],
+				(uint16_t) ((2 * n_regs) - 1));
+		if (rslt == BMA400_OK) {
+			/* Write-through of the new register values */
+			for (idx = 0; idx < n_regs; idx++) {
+				shadow_update(pairs[2 * idx], &pairs[(2 * idx) + 1], 1, dev);
+			}
+		} else {
+			/* Failure case */
+			rslt = BMA400_E_COM_FAIL;
+		}
+	}
+
+	return rslt;
+}
+
+static uint8_t shadow_reg_valid(uint8_t reg_addr,
+		const struct bma400_reg_shadow *shadow) {
+	uint8_t idx;
+	uint8_t auto_lp_idx = BMA400_AUTO_LOW_POW_1_ADDR - BMA400_SHADOW_START_ADDR;
+	uint8_t wakeup_idx = BMA400_AUTOWAKEUP_1_ADDR - BMA400_SHADOW_START_ADDR;
+
+	if ((reg_addr < BMA400_SHADOW_START_ADDR)
+			|| (reg_addr > BMA400_SHADOW_END_ADDR)) {
+		return FALSE;
+	}
+	idx = reg_addr - BMA400_SHADOW_START_ADDR;
+	if ((shadow->valid[idx / 8] & (1 << (idx % 8))) == 0) {
+		return FALSE;
+	}
+
+	/* The sensor changes the power mode on its own once auto low power
+	 * or auto wakeup is enabled, so the mode is read from the sensor
+	 */
+	if (reg_addr == BMA400_ACCEL_CONFIG_0_ADDR) {
+		if ((shadow_reg_valid(BMA400_AUTO_LOW_POW_1_ADDR, shadow) == FALSE)
+				|| (shadow_reg_valid(BMA400_AUTOWAKEUP_1_ADDR, shadow) == FALSE)
+				|| (shadow->regs[auto_lp_idx] & BMA400_AUTO_LOW_POW_MSK)
+				|| (shadow->regs[wakeup_idx]
+						& (BMA400_WAKEUP_INTERRUPT_MSK | BMA400_WAKEUP_TIMEOUT_MSK))) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+static uint8_t shadow_read(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
+		const struct bma400_dev *dev) {
+	uint8_t count;
+
+	if ((dev->shadow == NULL) || (len == 0)) {
+		return FALSE;
+	}
+	for (count = 0; count < len; count++) {
+		if (shadow_reg_valid(reg_addr + count, dev->shadow) == FALSE) {
+			return FALSE;
+		}
+	}
+	for (count = 0; count < len; count++) {
+		reg_data[count] = dev->shadow->regs[reg_addr + count
+				- BMA400_SHADOW_START_ADDR];
+	}
+
+	return TRUE;
+}
+
+static void shadow_update(uint8_t reg_addr, const uint8_t *reg_data,
+		uint16_t len, const struct bma400_dev *dev) {
+	uint16_t count;
+	uint16_t addr;
+	uint8_t idx;
+
+	/* The FIFO data register traps the address */
+	if ((dev->shadow == NULL) || (reg_addr == BMA400_FIFO_DATA_ADDR)) {
+		return;
+	}
+	for (count = 0; count < len; count++) {
+		addr = reg_addr + count;
+		if ((addr >= BMA400_SHADOW_START_ADDR)
+				&& (addr <= BMA400_SHADOW_END_ADDR)) {
+			idx = (uint8_t) (addr - BMA400_SHADOW_START_ADDR);
+			dev->shadow->regs[idx] = reg_data[count];
+			dev->shadow->valid[idx / 8] |= (uint8_t) (1 << (idx % 8));
+		}
+	}
+}
+
+static uint16_t shadow_check(uint8_t reg_addr, const uint8_t *reg_data,
+		uint16_t len, const struct bma400_dev *dev) {
+	uint16_t count;
+	uint16_t addr;
+	uint16_t mismatch = 0;
+	uint8_t idx;
+
+	if (dev->shadow == NULL) {
+		return 0;
+	}
+	for (count = 0; count < len; count++) {
+		addr = reg_addr + count;
+		if ((addr >= BMA400_SHADOW_START_ADDR)
+				&& (addr <= BMA400_SHADOW_END_ADDR)) {
+			idx = (uint8_t) (addr - BMA400_SHADOW_START_ADDR);
+			if ((dev->shadow->valid[idx / 8] & (1 << (idx % 8)))
+					&& (dev->shadow->regs[idx] != reg_data[count])) {
+				mismatch++;
+			}
+		}
+	}
+
+	return mismatch;
+}
+
+static void reset_conf_image(uint8_t *image) {
+	memset(image, 0, BMA400_CONF_IMAGE_LEN);
+	image[BMA400_ACCEL_CONFIG_1_ADDR - BMA400_CONF_IMAGE_START_ADDR] =
+			BMA400_CONF_IMAGE_RESET_CONFIG_1;
+	image[BMA400_INT_12_IO_CTRL_ADDR - BMA400_CONF_IMAGE_START_ADDR] =
+			BMA400_CONF_IMAGE_RESET_IO_CTRL;
+	image[BMA400_TAP_CONFIG_ADDR + 1 - BMA400_CONF_IMAGE_START_ADDR] =
+			BMA400_CONF_IMAGE_RESET_TAP_1;
+}
+
+static int8_t pack_conf_image(uint8_t *image,
+		const struct bma400_sensor_conf *sensor_conf, uint16_t n_sensor,
+		const struct bma400_device_conf *device_conf, uint8_t n_device) {
+	int8_t rslt = BMA400_OK;
+	uint16_t idx;
+	uint8_t *int_map = &image[BMA400_INT_MAP_ADDR
+			- BMA400_CONF_IMAGE_START_ADDR];
+
+	for (idx = 0; (idx < n_sensor) && (rslt == BMA400_OK); idx++) {
+		switch (sensor_conf[idx].type) {
+		case BMA400_ACCEL:
+			pack_accel_conf(
+					&image[BMA400_ACCEL_CONFIG_0_ADDR
+							- BMA400_CONF_IMAGE_START_ADDR],
+					&sensor_conf[idx].param.accel);
+			map_int_pin(int_map, BMA400_DATA_READY_INT_MAP,
+					sensor_conf[idx].param.accel.int_chan);
+			break;
+		case BMA400_TAP_INT:
+			pack_tap_conf(
+					&image[BMA400_TAP_CONFIG_ADDR - BMA400_CONF_IMAGE_START_ADDR],
+					&sensor_conf[idx].param.tap);
+			map_int_pin(int_map, BMA400_TAP_INT_MAP,
+					sensor_conf[idx].param.tap.int_chan);
+			break;
+		case BMA400_ACTIVITY_CHANGE_INT:
+			pack_activity_change_conf(
+					&image[BMA400_ACT_CH_CONFIG_0_ADDR
+							- BMA400_CONF_IMAGE_START_ADDR],
+					&sensor_conf[idx].param.act_ch);
+			map_int_pin(int_map, BMA400_ACT_CH_INT_MAP,
+					sensor_conf[idx].param.act_ch.int_chan);
+			break;
+		case BMA400_GEN1_INT:
+			(void) pack_gen_int(
+					&image[BMA400_GEN1_INT_CONFIG_ADDR
+							- BMA400_CONF_IMAGE_START_ADDR],
+					&sensor_conf[idx].param.gen_int);
+			map_int_pin(int_map, BMA400_GEN1_INT_MAP,
+					sensor_conf[idx].param.gen_int.int_chan);
+			break;
+		case BMA400_GEN2_INT:
+			(void) pack_gen_int(
+					&image[BMA400_GEN2_INT_CONFIG_ADDR
+							- BMA400_CONF_IMAGE_START_ADDR],
+					&sensor_conf[idx].param.gen_int);
+			map_int_pin(int_map, BMA400_GEN2_INT_MAP,
+					sensor_conf[idx].param.gen_int.int_chan);
+			break;
+		case BMA400_ORIENT_CHANGE_INT:
+			(void) pack_orient_int(
+					&image[BMA400_ORIENTCH_INT_CONFIG_ADDR
+							- BMA400_CONF_IMAGE_START_ADDR],
+					&sensor_conf[idx].param.orient);
+			map_int_pin(int_map, BMA400_ORIENT_CH_INT_MAP,
+					sensor_conf[idx].param.orient.int_chan);
+			break;
+		case BMA400_STEP_COUNTER_INT:
+			map_int_pin(int_map, BMA400_STEP_INT_MAP,
+					sensor_conf[idx].param.step_cnt.int_chan);
+			break;
+		default:
+			rslt = BMA400_E_INVALID_CONFIG;
+		}
+	}
+
+	for (idx = 0; (idx < n_device) && (rslt == BMA400_OK); idx++) {
+		switch (device_conf[idx].type) {
+		case BMA400_INT_PIN_CONF:
+			pack_int_pin_conf(
+					&image[BMA400_INT_12_IO_CTRL_ADDR
+							- BMA400_CONF_IMAGE_START_ADDR],
+					device_conf[idx].param.int_conf);
+			break;
+		case BMA400_INT_OVERRUN_CONF:
+			map_int_pin(int_map, BMA400_INT_OVERRUN_MAP,
+					device_conf[idx].param.overrun_int.int_chan);
+			break;
+		case BMA400_FIFO_CONF:
+			(void) pack_fifo_conf(
+					&image[BMA400_FIFO_CONFIG_0_ADDR
+							- BMA400_CONF_IMAGE_START_ADDR],
+					&device_conf[idx].param.fifo_conf);
+			map_int_pin(int_map, BMA400_FIFO_WM_INT_MAP,
+					device_conf[idx].param.fifo_conf.fifo_wm_channel);
+			map_int_pin(int_map, BMA400_FIFO_FULL_INT_MAP,
+					device_conf[idx].param.fifo_conf.fifo_full_channel);
+			break;
+		default:
+			/* Auto wakeup and auto low power are not part of the image */
+			rslt = BMA400_E_INVALID_CONFIG;
+		}
+	}
+
+	return rslt;
+}
@@ -51,12 +51,18 @@ extern "C" {
 #endif
 
 #include "bma400_defs.h"
+#include "sl_sleeptimer.h"
 
-uint8_t spi_read(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data,
-		uint16_t length);
-uint8_t spi_write(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data,
-		uint16_t length);
+/* Blocking register accesses of a sensor set up by bma400_spi_dev_init.
+ * With interrupts masked or from an interrupt handler they only run on an
+ * idle bus, and return BMA400_E_BUSY if a queued transaction holds it.
+ */
+int8_t spi_read(void *intf_ptr, uint8_t dev_id, uint8_t reg_addr,
+		uint8_t *reg_data, uint16_t length);
+int8_t spi_write(void *intf_ptr, uint8_t dev_id, uint8_t reg_addr,
+		uint8_t *reg_data, uint16_t length);
 void delay(uint32_t ms);
+void delay_us(uint32_t us);
 void print_rslt(int8_t rslt);
 
 /**
@@ -84,6 +90,250 @@ void print_rslt(int8_t rslt);
  */
 int8_t bma400_init(struct bma400_dev *dev);
 
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_init_async bma400_init_async
+ * \code
+ * int8_t bma400_init_async(struct bma400_bringup *bu, bma400_bringup_cb_t notify,
+ *                          void *cb_ctx, struct bma400_dev *dev);
+ * \endcode
+ * @details This API is the non-blocking counterpart of bma400_init(). Instead
+ * of waiting out the power-up time, the chip-id is polled every
+ * BMA400_BRINGUP_POLL_MS from a sleeptimer, for at most
+ * BMA400_POWER_UP_TIMEOUT_MS, and the initialization ends as soon as the
+ * sensor answers.
+ *
+ * While BMA400_W_IN_PROGRESS is returned, the application keeps calling
+ * bma400_bringup_process(), e.g. from its event loop, and the MCU may sleep
+ * in between. The sleeptimer interrupt calls notify, if any, whenever a
+ * poll is due; the stack can be woken from there with an external signal.
+ *
+ * @param[in,out] bu     : Bring-up context, zero-initialized before first use
+ * @param[in] notify     : Notification of a due poll. May be NULL.
+ * @param[in] cb_ctx     : Context passed to notify
+ * @param[in,out] dev    : Structure instance of bma400_dev
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success, the sensor is ready
+ * @retval Postive Warning, BMA400_W_IN_PROGRESS while waiting
+ * @retval Negative Error
+ */
+int8_t bma400_init_async(struct bma400_bringup *bu, bma400_bringup_cb_t notify,
+		void *cb_ctx, struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_soft_reset_async bma400_soft_reset_async
+ * \code
+ * int8_t bma400_soft_reset_async(struct bma400_bringup *bu, bma400_bringup_cb_t notify,
+ *                                void *cb_ctx, struct bma400_dev *dev);
+ * \endcode
+ * @details This API is the non-blocking counterpart of bma400_soft_reset().
+ * The first poll follows BMA400_SOFT_RESET_DELAY_MS after the reset
+ * command, so this call returns BMA400_W_IN_PROGRESS. The reset then ends
+ * as soon as the sensor answers with its chip-id again, after at most
+ * BMA400_SOFT_RESET_TIMEOUT_MS. It is driven the same way as
+ * bma400_init_async().
+ *
+ * @param[in,out] bu     : Bring-up context
+ * @param[in] notify     : Notification of a due poll. May be NULL.
+ * @param[in] cb_ctx     : Context passed to notify
+ * @param[in] dev        : Structure instance of bma400_dev
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success, the sensor is ready
+ * @retval Postive Warning, BMA400_W_IN_PROGRESS while waiting
+ * @retval Negative Error
+ */
+int8_t bma400_soft_reset_async(struct bma400_bringup *bu,
+		bma400_bringup_cb_t notify, void *cb_ctx, struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_set_power_mode_async bma400_set_power_mode_async
+ * \code
+ * int8_t bma400_set_power_mode_async(struct bma400_bringup *bu, uint8_t power_mode,
+ *                                    bma400_bringup_cb_t notify, void *cb_ctx,
+ *                                    struct bma400_dev *dev);
+ * \endcode
+ * @details This API is the non-blocking counterpart of bma400_set_power_mode().
+ * The power mode status is polled and the switch ends once it reports the
+ * new mode, or after the fixed delay of the blocking API at the latest. It
+ * is driven the same way as bma400_init_async().
+ *
+ * @param[in,out] bu     : Bring-up context
+ * @param[in] power_mode : Power mode to be set
+ * @param[in] notify     : Notification of a due poll. May be NULL.
+ * @param[in] cb_ctx     : Context passed to notify
+ * @param[in] dev        : Structure instance of bma400_dev
+ *
+ * @note After bma400_boot() with a power mode in the image, this API waits
+ * for that mode to settle; the register write is then a no-op.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success, the power mode is set
+ * @retval Postive Warning, BMA400_W_IN_PROGRESS while waiting
+ * @retval Negative Error
+ */
+int8_t bma400_set_power_mode_async(struct bma400_bringup *bu,
+		uint8_t power_mode, bma400_bringup_cb_t notify, void *cb_ctx,
+		struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_bringup_process bma400_bringup_process
+ * \code
+ * int8_t bma400_bringup_process(struct bma400_bringup *bu);
+ * \endcode
+ * @details This API advances the current asynchronous operation. It only
+ * accesses the sensor when a poll is due, otherwise it returns right away.
+ *
+ * @param[in,out] bu     : Bring-up context
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success, no operation pending any more
+ * @retval Postive Warning, BMA400_W_IN_PROGRESS while waiting
+ * @retval Negative Error, the operation has ended
+ */
+int8_t bma400_bringup_process(struct bma400_bringup *bu);
+
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_bringup_abort bma400_bringup_abort
+ * \code
+ * int8_t bma400_bringup_abort(struct bma400_bringup *bu);
+ * \endcode
+ * @details This API stops waiting for the current asynchronous operation,
+ * e.g. before entering EM4.
+ *
+ * @param[in,out] bu     : Bring-up context
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_bringup_abort(struct bma400_bringup *bu);
+
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_spi_bus_init bma400_spi_bus_init
+ * \code
+ * int8_t bma400_spi_bus_init(struct bma400_spi_bus *bus, const SPIDRV_Init_t *init);
+ * \endcode
+ * @details This API initializes the SPIDRV instance of a USART once, to be
+ * shared by all the sensors wired to it. The chip selects are driven by the
+ * devices, whatever the csControl of init.
+ *
+ * @param[out] bus      : Structure instance of bma400_spi_bus, to be kept
+ *                        valid while the bus is in use
+ * @param[in] init      : SPIDRV configuration of the USART
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_spi_bus_init(struct bma400_spi_bus *bus,
+		const SPIDRV_Init_t *init);
+
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_spi_dev_init bma400_spi_dev_init
+ * \code
+ * int8_t bma400_spi_dev_init(struct bma400_spi_dev *spi, struct bma400_spi_bus *bus,
+ *                            uint8_t cs_port, uint8_t cs_pin, uint32_t bit_rate,
+ *                            struct bma400_dev *dev);
+ * \endcode
+ * @details This API attaches a sensor to an SPI bus. The chip select GPIO is
+ * configured, and the interface, intf_ptr, read, write and delay_ms of dev
+ * are set so that all its transfers go through the bus. Other devices on
+ * the bus, such as the MX25 flash, are attached with a NULL dev and
+ * accessed with bma400_spi_submit().
+ *
+ * @param[out] spi      : Structure instance of bma400_spi_dev, to be kept
+ *                        valid while dev is in use
+ * @param[in] bus       : Initialized bus the sensor is wired to
+ * @param[in] cs_port   : MCU GPIO port of the chip select
+ * @param[in] cs_pin    : MCU GPIO pin of the chip select
+ * @param[in] bit_rate  : SPI bit rate, 0 or above BMA400_SPI_MAX_BIT_RATE for
+ *                        the highest one of the sensor
+ * @param[in,out] dev   : Structure instance of bma400_dev, or NULL
+ *
+ * @note The USART bit rate is switched only when the next transfer is for
+ * another device than the previous one.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_spi_dev_init(struct bma400_spi_dev *spi,
+		struct bma400_spi_bus *bus, uint8_t cs_port, uint8_t cs_pin,
+		uint32_t bit_rate, struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_spi_submit bma400_spi_submit
+ * \code
+ * int8_t bma400_spi_submit(struct bma400_spi_xfer *xfer);
+ * \endcode
+ * @details This API queues a transaction on the bus of xfer->spi and starts
+ * it if the bus is idle. Waiting transactions are served by priority, then
+ * in submission order, each in its own chip select frame. The callback is
+ * called from interrupt context once the transaction has completed, and
+ * may submit it again.
+ *
+ * A transaction with n_segs set is a scatter-gather one: up to
+ * BMA400_SPI_SG_MAX_SEGS segments, each in its own chip select frame, run
+ * as linked LDMA descriptors. The chip select toggles between the segments
+ * and the TX/RX pacing are sequenced by the LDMA, with a single interrupt
+ * at the end. E.g. the status block, FIFO length and FIFO data can be read
+ * as three segments, each starting with its address byte.
+ *
+ * The blocking register accesses of the sensors and the asynchronous FIFO
+ * reads are queued at BMA400_SPI_PRIO_URGENT, so that a FIFO drain waits
+ * at most for the transaction in progress, e.g. a flash page program
+ * queued at BMA400_SPI_PRIO_BULK.
+ *
+ * @param[in,out] xfer  : Transaction, to be kept valid until completion.
+ *
+ * @note A transaction in progress is not preempted, long bulk transfers
+ * are better split.
+ *
+ * @note Scatter-gather transactions use the BMA400_SPI_SG_SYNC_MSK bit of
+ * LDMA SYNC, which must not be used elsewhere.
+ *
+ * @note Completion relies on the LDMA interrupt. The blocking register
+ * accesses queued behind a transaction in progress are therefore refused
+ * with BMA400_E_BUSY when interrupts are masked or from an interrupt
+ * handler; on an idle bus they run directly.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error (BMA400_E_BUSY if xfer is already queued)
+ */
+int8_t bma400_spi_submit(struct bma400_spi_xfer *xfer);
+
+/*!
+ * \ingroup bma400ApiInit
+ * \page bma400_api_bma400_spi_cancel bma400_spi_cancel
+ * \code
+ * int8_t bma400_spi_cancel(struct bma400_spi_xfer *xfer);
+ * \endcode
+ * @details This API removes a transaction from the queue of its bus before
+ * it has started. Its callback is not called.
+ *
+ * @param[in,out] xfer  : Transaction.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success, also when xfer was not queued
+ * @retval Postive Warning
+ * @retval Negative Error (BMA400_E_BUSY if xfer is in progress)
+ */
+int8_t bma400_spi_cancel(struct bma400_spi_xfer *xfer);
+
 /**
  * \ingroup bma400
  * \defgroup bma400ApiData Data read out
@@ -120,6 +370,165 @@ int8_t bma400_init(struct bma400_dev *dev);
 int8_t bma400_get_accel_data(uint8_t data_sel, struct bma400_sensor_data *accel,
 		const struct bma400_dev *dev);
 
+/*!
+ * \ingroup bma400ApiData
+ * \page bma400_api_bma400_dma_poll_start bma400_dma_poll_start
+ * \code
+ * int8_t bma400_dma_poll_start(struct bma400_dma_poll *poll, uint8_t batch, enum bma400_int_chan int_chan,
+ *                              uint8_t gpio_port, uint8_t gpio_pin, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API starts the autonomous polling of the accel data. The
+ * data ready interrupt is mapped to an active high push-pull pin, whose
+ * rising edges raise the GPIO interrupt of the MCU pin wired to it. That
+ * interrupt wakes the MCU up from EM2 and releases pre-armed LDMA
+ * descriptor chains by a software request. They select the device, read
+ * the accel data and sensor time in one burst into a ring of two batches
+ * and deselect the device, without the CPU. The application is only woken
+ * up once a batch is filled, and then calls bma400_dma_poll_read.
+ *
+ * @param[out] poll     : Structure instance of bma400_dma_poll.
+ * @param[in] batch     : Samples per wakeup, 1 to BMA400_DMA_POLL_MAX_BATCH.
+ * @param[in] int_chan  : BMA400_INT_CHANNEL_1 or BMA400_INT_CHANNEL_2.
+ * @param[in] gpio_port : MCU GPIO port wired to the interrupt pin.
+ * @param[in] gpio_pin  : MCU GPIO pin wired to the interrupt pin, which
+ *                        selects its GPIO interrupt.
+ * @param[in] dev       : Structure instance of bma400_dev, set up with
+ *                        bma400_spi_dev_init().
+ *
+ * @note The USART and the LDMA do not run in EM2. Each sample blocks EM2
+ * from its data ready edge until its frame is received, some tens of
+ * microseconds, and the MCU sleeps in EM2 between samples.
+ *
+ * @note The interrupts are switched to non-latched mode, as the frames do
+ * not read the interrupt status. bma400_dma_poll_stop restores the mode.
+ *
+ * @note The polling starts only on an idle bus and keeps it until
+ * bma400_dma_poll_stop is called. Blocking transfers meanwhile return
+ * BMA400_E_BUSY, submitted transactions wait for the stop. A single
+ * polling can be armed at a time.
+ *
+ * @note A frame must end before the next data ready edge, which holds at
+ * any output data rate for bit rates above 200 kHz.
+ *
+ * @code
+ *  bma400_dma_poll_start(&poll, 8, BMA400_INT_CHANNEL_1, gpioPortD, 10, &bma);
+ *  while (1) {
+ *      if (bma400_dma_poll_read(&poll, accel, &n_samples) == BMA400_OK) {
+ *          ...
+ *      } else {
+ *          SLEEP_Sleep();
+ *      }
+ *  }
+ * @endcode
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error (BMA400_E_BUSY while a transfer is in progress)
+ */
+int8_t bma400_dma_poll_start(struct bma400_dma_poll *poll, uint8_t batch,
+		enum bma400_int_chan int_chan, uint8_t gpio_port, uint8_t gpio_pin,
+		const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiData
+ * \page bma400_api_bma400_dma_poll_read bma400_dma_poll_read
+ * \code
+ * int8_t bma400_dma_poll_read(struct bma400_dma_poll *poll, struct bma400_sensor_data *accel,
+ *                             uint8_t *n_samples);
+ * \endcode
+ * @details This API unpacks the oldest filled batch of the autonomous
+ * polling, with the sensor time of each sample. No bus access is made.
+ *
+ * @param[in,out] poll     : Structure instance of bma400_dma_poll.
+ * @param[out] accel       : Array of at least batch samples.
+ * @param[out] n_samples   : Number of samples unpacked, batch or 0.
+ *
+ * @note The batch must be read before the LDMA fills it again, one batch
+ * period later. The batches filled again first are counted in
+ * poll->overruns.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_NO_DATA when no batch is filled)
+ * @retval Negative Error
+ */
+int8_t bma400_dma_poll_read(struct bma400_dma_poll *poll,
+		struct bma400_sensor_data *accel, uint8_t *n_samples);
+
+/*!
+ * \ingroup bma400ApiData
+ * \page bma400_api_bma400_dma_poll_stop bma400_dma_poll_stop
+ * \code
+ * int8_t bma400_dma_poll_stop(struct bma400_dma_poll *poll, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API stops the autonomous polling, gives the bus back,
+ * disables the data ready interrupt and restores the interrupt latching.
+ * The samples of a partly filled batch are dropped.
+ *
+ * @param[in,out] poll   : Structure instance of bma400_dma_poll.
+ * @param[in] dev        : Structure instance of bma400_dev.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_dma_poll_stop(struct bma400_dma_poll *poll,
+		const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiData
+ * \page bma400_api_bma400_lsb_to_mg bma400_lsb_to_mg
+ * \code
+ * int8_t bma400_lsb_to_mg(const int16_t *lsb, int16_t *mg, uint16_t n,
+ *                         uint8_t range, uint8_t resolution);
+ * \endcode
+ * @details This API converts a block of raw accel samples to mg, rounded to
+ * the nearest mg, using one constant multiplier per range and resolution.
+ *
+ * @param[in] lsb          : Raw samples
+ * @param[out] mg          : Converted samples, may alias lsb
+ * @param[in] n            : Number of samples
+ * @param[in] range        : BMA400_2G_RANGE to BMA400_16G_RANGE
+ * @param[in] resolution   : BMA400_12_BIT_RESOLUTION or BMA400_8_BIT_RESOLUTION
+ *
+ * @note Data from bma400_get_accel_data() and the FIFO extraction APIs is
+ * already 12-bit, also in compact FIFO mode.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_lsb_to_mg(const int16_t *lsb, int16_t *mg, uint16_t n,
+		uint8_t range, uint8_t resolution);
+
+/*!
+ * \ingroup bma400ApiData
+ * \page bma400_api_bma400_lsb_to_q15_g bma400_lsb_to_q15_g
+ * \code
+ * int8_t bma400_lsb_to_q15_g(const int16_t *lsb, int32_t *g_q15, uint16_t n,
+ *                            uint8_t range, uint8_t resolution);
+ * \endcode
+ * @details This API converts a block of raw accel samples to g in Q15
+ * (32768 = 1 g). The conversion is exact, a single shift per sample.
+ *
+ * @param[in] lsb          : Raw samples
+ * @param[out] g_q15       : Converted samples in Q15 g
+ * @param[in] n            : Number of samples
+ * @param[in] range        : BMA400_2G_RANGE to BMA400_16G_RANGE
+ * @param[in] resolution   : BMA400_12_BIT_RESOLUTION or BMA400_8_BIT_RESOLUTION
+ *
+ * @note The output is 32-bit since ranges above 1 g do not fit a 16-bit Q15.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_lsb_to_q15_g(const int16_t *lsb, int32_t *g_q15, uint16_t n,
+		uint8_t range, uint8_t resolution);
+
 /**
  * \ingroup bma400
  * \defgroup bma400ApiConfig Configuration
@@ -283,6 +692,114 @@ int8_t bma400_set_device_conf(const struct bma400_device_conf *conf,
 int8_t bma400_get_device_conf(struct bma400_device_conf *conf, uint8_t n_sett,
 		const struct bma400_dev *dev);
 
+/*!
+ * \ingroup bma400ApiConfig
+ * \page bma400_api_bma400_apply_conf bma400_apply_conf
+ * \code
+ * int8_t bma400_apply_conf(const struct bma400_sensor_conf *sensor_conf, uint16_t n_sensor,
+ *                          const struct bma400_device_conf *device_conf, uint8_t n_device,
+ *                          uint8_t *n_written, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API brings the sensor to a desired configuration. The target
+ * register values are computed from the current ones, and only the registers
+ * that change are written, in a single register batch.
+ *
+ * Supported sensor settings:
+ *  - BMA400_ACCEL
+ *  - BMA400_TAP_INT
+ *  - BMA400_ACTIVITY_CHANGE_INT
+ *  - BMA400_GEN1_INT
+ *  - BMA400_GEN2_INT
+ *  - BMA400_ORIENT_CHANGE_INT
+ *  - BMA400_STEP_COUNTER_INT
+ *
+ * Supported device settings:
+ *  - BMA400_INT_PIN_CONF
+ *  - BMA400_INT_OVERRUN_CONF
+ *  - BMA400_FIFO_CONF
+ *
+ * @param[in] sensor_conf : Sensor configurations, may be NULL if n_sensor is 0
+ * @param[in] n_sensor    : Number of sensor configurations
+ * @param[in] device_conf : Device configurations, may be NULL if n_device is 0
+ * @param[in] n_device    : Number of device configurations
+ * @param[out] n_written  : Number of registers written. May be NULL.
+ * @param[in] dev         : Structure instance of bma400_dev.
+ *
+ * @note Nothing is written when an unsupported setting is given. With a
+ * register shadow attached, a configuration without changes needs no
+ * bus access at all.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_apply_conf(const struct bma400_sensor_conf *sensor_conf,
+		uint16_t n_sensor, const struct bma400_device_conf *device_conf,
+		uint8_t n_device, uint8_t *n_written, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiConfig
+ * \page bma400_api_bma400_boot_image_build bma400_boot_image_build
+ * \code
+ * int8_t bma400_boot_image_build(const struct bma400_sensor_conf *sensor_conf, uint16_t n_sensor,
+ *                                const struct bma400_device_conf *device_conf, uint8_t n_device,
+ *                                uint8_t power_mode, struct bma400_boot_image *image);
+ * \endcode
+ * @details This API reduces a complete sensor configuration to a boot image:
+ * the register values it results in after a reset, and the address/data
+ * pairs of the registers that differ from their reset values. No bus access
+ * is made.
+ *
+ * The image is plain data. It can be built once, on the host or at first
+ * boot, and kept as static const data or in retained memory, so that later
+ * boots only run bma400_boot().
+ *
+ * @param[in] sensor_conf : Sensor configurations, may be NULL if n_sensor is 0
+ * @param[in] n_sensor    : Number of sensor configurations
+ * @param[in] device_conf : Device configurations, may be NULL if n_device is 0
+ * @param[in] n_device    : Number of device configurations
+ * @param[in] power_mode  : Power mode entered once the image is applied
+ * @param[out] image      : Boot image
+ *
+ * The supported settings are the ones of bma400_apply_conf().
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_boot_image_build(const struct bma400_sensor_conf *sensor_conf,
+		uint16_t n_sensor, const struct bma400_device_conf *device_conf,
+		uint8_t n_device, uint8_t power_mode, struct bma400_boot_image *image);
+
+/*!
+ * \ingroup bma400ApiConfig
+ * \page bma400_api_bma400_boot bma400_boot
+ * \code
+ * int8_t bma400_boot(const struct bma400_boot_image *image, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API applies a boot image to a sensor fresh out of reset.
+ * All registers of the image are written within one transaction as long as
+ * they fit in a register batch, with no reads and no delays. With a register
+ * shadow attached, the whole configuration window is known afterwards.
+ *
+ * @param[in] image : Boot image from bma400_boot_image_build()
+ * @param[in] dev   : Structure instance of bma400_dev.
+ *
+ * @note Call bma400_init() first. The registers not listed in the image are
+ * assumed to hold their reset values, which holds after power-up; a sensor
+ * that kept its supply has to be reset with bma400_soft_reset(). The power
+ * mode settles within 1/ODR, the first sample is signalled as usual.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_boot(const struct bma400_boot_image *image,
+		const struct bma400_dev *dev);
+
 /**
  * \ingroup bma400
  * \defgroup bma400ApiFifo FIFO
@@ -323,6 +840,12 @@ int8_t bma400_set_fifo_flush(const struct bma400_dev *dev);
  * fifo->length , It will be updated by the number of bytes actually
  * read from FIFO after calling this API
  *
+ * @note The FIFO is read in place: the first BMA400_FIFO_HEADROOM bytes of
+ * the buffer carry the address byte, followed by the dummy byte on SPI and
+ * then the FIFO data. fifo->length includes the address and dummy bytes,
+ * so up to fifo->length - BMA400_FIFO_HEADROOM - dev->dummy_byte FIFO
+ * bytes are read.
+ *
  * @param[in,out] fifo      : Pointer to the FIFO structure.
  *
  * @param[in,out] dev       : Structure instance of bma400_dev.
@@ -335,6 +858,41 @@ int8_t bma400_set_fifo_flush(const struct bma400_dev *dev);
 int8_t bma400_get_fifo_data(struct bma400_fifo_data *fifo,
 		const struct bma400_dev *dev);
 
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_get_fifo_data_async bma400_get_fifo_data_async
+ * \code
+ * int8_t bma400_get_fifo_data_async(struct bma400_fifo_data *fifo, bma400_fifo_cb_t callback,
+ *                                   void *cb_ctx, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API starts a non-blocking read of the FIFO data. The FIFO
+ * length and configuration are read before returning, the FIFO data itself
+ * is moved by DMA and the callback is called from interrupt context once
+ * the transfer has completed.
+ *
+ * @param[in,out] fifo  : Pointer to the FIFO structure, to be kept valid
+ *                        until the callback is called.
+ * @param[in] callback  : Completion callback.
+ * @param[in] cb_ctx    : User context passed to the callback.
+ * @param[in] dev       : Structure instance of bma400_dev, set up with
+ *                        bma400_spi_dev_init().
+ *
+ * @note The buffer layout is the same as for bma400_get_fifo_data, so
+ * bma400_extract_accel can be called from the callback.
+ *
+ * @note FIFO reading is left enabled after the transfer.
+ *
+ * @note The transfer is queued on the bus at BMA400_SPI_PRIO_URGENT, ahead
+ * of the waiting transactions of other devices.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error (BMA400_E_BUSY while a FIFO read is in progress)
+ */
+int8_t bma400_get_fifo_data_async(struct bma400_fifo_data *fifo,
+		bma400_fifo_cb_t callback, void *cb_ctx, const struct bma400_dev *dev);
+
 /*!
  * \ingroup bma400ApiFifo
  * \page bma400_api_bma400_extract_accel bma400_extract_accel
@@ -371,35 +929,486 @@ int8_t bma400_extract_accel(struct bma400_fifo_data *fifo,
 		struct bma400_sensor_data *accel_data, uint16_t *frame_count,
 		const struct bma400_dev *dev);
 
-/**
- * \ingroup bma400
- * \defgroup bma400ApiInterrupt Interrupt
- * @brief Interrupt API
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_fifo_acq_start bma400_fifo_acq_start
+ * \code
+ * int8_t bma400_fifo_acq_start(struct bma400_fifo_acq *acq, uint8_t *buf0, uint8_t *buf1, uint16_t length,
+ *                              uint32_t bit_rate, bma400_fifo_cb_t callback, void *cb_ctx,
+ *                              const struct bma400_dev *dev);
+ * \endcode
+ * @details This API starts a continuous FIFO acquisition. The chip select
+ * is held low and the FIFO data register is read without interruption by
+ * DMA, alternately into buf0 and buf1. The callback is called from interrupt
+ * context for each filled buffer, while DMA fills the other one.
+ *
+ * @param[out] acq      : Structure instance of bma400_fifo_acq.
+ * @param[in] buf0      : First buffer of length bytes.
+ * @param[in] buf1      : Second buffer of length bytes.
+ * @param[in] length    : Length of each buffer, headroom included.
+ * @param[in] bit_rate  : SPI bit rate during the acquisition, 0 to keep the
+ *                        one of the device.
+ * @param[in] callback  : Called with each filled buffer.
+ * @param[in] cb_ctx    : User context passed to the callback.
+ * @param[in] dev       : Structure instance of bma400_dev, set up with
+ *                        bma400_spi_dev_init().
+ *
+ * @note Each buffer has the layout of bma400_get_fifo_data, the callback
+ * passes it to bma400_extract_accel_stream so that frames split between
+ * the two buffers are kept. It must return before the other buffer is
+ * filled.
+ *
+ * @note When the FIFO is empty, the sensor returns empty frames, which the
+ * parser skips. A bit rate of about twice the FIFO data rate (e.g. 100 kHz
+ * for 12 bit XYZ at 800 Hz) keeps the latency at the buffer period without
+ * much overhead.
+ *
+ * @note The acquisition starts only on an idle bus and keeps it until
+ * bma400_fifo_acq_stop is called. Blocking transfers meanwhile return
+ * BMA400_E_BUSY, submitted transactions wait for the stop.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error (BMA400_E_BUSY while a transfer is in progress)
  */
+int8_t bma400_fifo_acq_start(struct bma400_fifo_acq *acq, uint8_t *buf0,
+		uint8_t *buf1, uint16_t length, uint32_t bit_rate,
+		bma400_fifo_cb_t callback, void *cb_ctx, const struct bma400_dev *dev);
 
 /*!
- * \ingroup bma400ApiInterrupt
- * \page bma400_api_bma400_get_interrupt_status bma400_get_interrupt_status
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_fifo_acq_stop bma400_fifo_acq_stop
  * \code
- * int8_t bma400_get_interrupt_status(uint16_t *int_status, const struct bma400_dev *dev);
+ * int8_t bma400_fifo_acq_stop(struct bma400_fifo_acq *acq);
  * \endcode
- * @details This API is used to check if the interrupts are asserted and return the status.
+ * @details This API stops a continuous FIFO acquisition and gives the bus
+ * back to SPIDRV. The data of a partly filled buffer is dropped.
  *
- * @param[in] int_status   : Interrupt status of sensor
- * @param[in] dev          : Structure instance of bma400_dev.
+ * @param[in,out] acq   : Structure instance of bma400_fifo_acq.
  *
- * @note Interrupt status of the sensor determines which all interrupts are asserted at any instant of time.
- * @code
- *  BMA400_WAKEUP_INT_ASSERTED
- *  BMA400_ORIENT_CH_INT_ASSERTED
- *  BMA400_GEN1_INT_ASSERTED
- *  BMA400_GEN2_INT_ASSERTED
- *  BMA400_FIFO_FULL_INT_ASSERTED
- *  BMA400_FIFO_WM_INT_ASSERTED
- *  BMA400_DRDY_INT_ASSERTED
- *  BMA400_INT_OVERRUN_ASSERTED
- *  BMA400_STEP_INT_ASSERTED
- *  BMA400_S_TAP_INT_ASSERTED
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_fifo_acq_stop(struct bma400_fifo_acq *acq);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_fifo_wm_acq_start bma400_fifo_wm_acq_start
+ * \code
+ * int8_t bma400_fifo_wm_acq_start(struct bma400_fifo_wm_acq *acq, uint16_t watermark,
+ *                                 enum bma400_int_chan int_chan, uint8_t gpio_port, uint8_t gpio_pin,
+ *                                 const struct bma400_dev *dev);
+ * \endcode
+ * @details This API starts an acquisition driven by the FIFO watermark
+ * interrupt. The watermark is mapped to an active high push-pull interrupt
+ * pin, and the MCU GPIO wired to it raises a GPIO interrupt on the rising
+ * edge. The application sleeps, e.g. in EM2, until the interrupt comes and
+ * then calls bma400_fifo_wm_acq_read.
+ *
+ * @param[out] acq      : Structure instance of bma400_fifo_wm_acq.
+ * @param[in] watermark : FIFO watermark in bytes.
+ * @param[in] int_chan  : BMA400_INT_CHANNEL_1 or BMA400_INT_CHANNEL_2.
+ * @param[in] gpio_port : MCU GPIO port wired to the interrupt pin.
+ * @param[in] gpio_pin  : MCU GPIO pin wired to the interrupt pin, also used
+ *                        as GPIO interrupt number.
+ * @param[in] dev       : Structure instance of bma400_dev.
+ *
+ * @note GPIOINT_Init must have been called by the application.
+ *
+ * @code
+ *  bma400_fifo_wm_acq_start(&acq, 600, BMA400_INT_CHANNEL_1, gpioPortD, 10, &bma);
+ *  while (1) {
+ *      fifo.length = sizeof(fifo_buff);
+ *      if (bma400_fifo_wm_acq_read(&acq, &fifo, &bma) == BMA400_OK) {
+ *          ...
+ *      } else {
+ *          EMU_EnterEM2(true);
+ *      }
+ *  }
+ * @endcode
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_fifo_wm_acq_start(struct bma400_fifo_wm_acq *acq,
+		uint16_t watermark, enum bma400_int_chan int_chan, uint8_t gpio_port,
+		uint8_t gpio_pin, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_fifo_wm_acq_read bma400_fifo_wm_acq_read
+ * \code
+ * int8_t bma400_fifo_wm_acq_read(struct bma400_fifo_wm_acq *acq, struct bma400_fifo_data *fifo,
+ *                                const struct bma400_dev *dev);
+ * \endcode
+ * @details This API reads the FIFO data like "bma400_get_fifo_data" once
+ * the watermark interrupt has been raised.
+ *
+ * @param[in,out] acq   : Structure instance of bma400_fifo_wm_acq.
+ * @param[in,out] fifo  : Pointer to the FIFO structure.
+ * @param[in] dev       : Structure instance of bma400_dev.
+ *
+ * @note The FIFO buffer should hold more than the watermark, so that the
+ * fill level drops below it and the next interrupt makes a new edge.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_NO_DATA when no watermark is pending)
+ * @retval Negative Error
+ */
+int8_t bma400_fifo_wm_acq_read(struct bma400_fifo_wm_acq *acq,
+		struct bma400_fifo_data *fifo, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_fifo_wm_acq_stop bma400_fifo_wm_acq_stop
+ * \code
+ * int8_t bma400_fifo_wm_acq_stop(struct bma400_fifo_wm_acq *acq, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API stops a watermark interrupt acquisition. The GPIO
+ * interrupt and the FIFO watermark interrupt are disabled.
+ *
+ * @param[in,out] acq   : Structure instance of bma400_fifo_wm_acq.
+ * @param[in] dev       : Structure instance of bma400_dev.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_fifo_wm_acq_stop(struct bma400_fifo_wm_acq *acq,
+		const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_extract_accel_soa bma400_extract_accel_soa
+ * \code
+ * int8_t bma400_extract_accel_soa(struct bma400_fifo_data *fifo, const struct bma400_accel_soa *accel_data,
+ *                                 uint16_t *frame_count, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API parses the FIFO data like "bma400_extract_accel", but
+ * stores the accelerometer data of each axis in its own contiguous array.
+ * The arrays can be passed directly to CMSIS-DSP q15 functions.
+ *
+ * @param[in,out] fifo        : Pointer to the FIFO structure.
+ *
+ * @param[in] accel_data      : Arrays of at least frame_count elements where
+ *                              the accelerometer data from FIFO is stored.
+ *                              accel_data->sensortime may be NULL.
+ *
+ * @param[in,out] frame_count : Number of valid accelerometer frames requested
+ *                              by user is given as input and it is updated by
+ *                              the actual frames parsed from the FIFO
+ *
+ * @param[in] dev             : Structure instance of bma400_dev.
+ *
+ * @note Axes missing from a frame are stored as 0. Each sensortime element
+ * is set to the sensor time read with the FIFO batch, 0 when none was read.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_extract_accel_soa(struct bma400_fifo_data *fifo,
+		const struct bma400_accel_soa *accel_data, uint16_t *frame_count,
+		const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_sensortime_reset bma400_sensortime_reset
+ * \code
+ * int8_t bma400_sensortime_reset(struct bma400_sensortime *sensortime);
+ * \endcode
+ * @details This API resets a 64 bit sensor time clock. The next sensor
+ * time value starts it again.
+ *
+ * @param[out] sensortime : Structure instance of bma400_sensortime.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_sensortime_reset(struct bma400_sensortime *sensortime);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_sensortime_extend bma400_sensortime_extend
+ * \code
+ * int8_t bma400_sensortime_extend(struct bma400_sensortime *sensortime, uint32_t raw, uint64_t *time);
+ * \endcode
+ * @details This API extends a raw 24 bit sensor time, as read by
+ * "bma400_get_accel_data" or from the FIFO, to a 64 bit monotonic clock.
+ *
+ * @param[in,out] sensortime : Structure instance of bma400_sensortime.
+ * @param[in] raw            : Raw 24 bit sensor time.
+ * @param[out] time          : Sensor time in ticks of 39.0625 us.
+ *
+ * @note The raw sensor time wraps every 655 s, so this API must be called
+ * at least once per wrap period.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_sensortime_extend(struct bma400_sensortime *sensortime,
+		uint32_t raw, uint64_t *time);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_fifo_timestamps bma400_fifo_timestamps
+ * \code
+ * int8_t bma400_fifo_timestamps(struct bma400_sensortime *sensortime, const struct bma400_fifo_data *fifo,
+ *                               uint16_t frame_count, uint8_t odr, uint64_t *timestamps);
+ * \endcode
+ * @details This API computes a 64 bit timestamp for every frame extracted
+ * from a FIFO read. The last frame is placed on the sample period before
+ * the sensor time frame of the read, and earlier frames one sample period
+ * apart. Reads without a sensor time frame continue from the previous read.
+ *
+ * @param[in,out] sensortime : Structure instance of bma400_sensortime.
+ * @param[in] fifo           : FIFO structure of the read.
+ * @param[in] frame_count    : Number of frames extracted from the read.
+ * @param[in] odr            : ODR of the FIFO data, BMA400_ODR_12_5HZ to
+ *                             BMA400_ODR_800HZ.
+ * @param[out] timestamps    : Timestamps in ticks of 39.0625 us, one per
+ *                             frame.
+ *
+ * @note BMA400_FIFO_TIME_EN must be enabled and all frames of the read
+ * extracted. Timestamps convert to micro seconds with
+ * BMA400_SENSORTIME_TO_US.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_NO_DATA before the first sensor time)
+ * @retval Negative Error
+ */
+int8_t bma400_fifo_timestamps(struct bma400_sensortime *sensortime,
+		const struct bma400_fifo_data *fifo, uint16_t frame_count,
+		uint8_t odr, uint64_t *timestamps);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_clock_sync_init bma400_clock_sync_init
+ * \code
+ * int8_t bma400_clock_sync_init(struct bma400_clock_sync *sync, uint8_t gain_shift);
+ * \endcode
+ * @details This API initializes the estimate of the sensor clock against
+ * the sleeptimer clock to the nominal rate.
+ *
+ * @param[out] sync      : Structure instance of bma400_clock_sync.
+ * @param[in] gain_shift : Filter gain as a right shift, e.g. 3 weights each
+ *                         new pair by 1/8.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_clock_sync_init(struct bma400_clock_sync *sync,
+		uint8_t gain_shift);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_clock_sync_update bma400_clock_sync_update
+ * \code
+ * int8_t bma400_clock_sync_update(struct bma400_clock_sync *sync, uint64_t sensortime, uint64_t tick);
+ * \endcode
+ * @details This API adds a pair of 64 bit sensor time and sleeptimer tick
+ * taken at the same instant. The rate and offset of the sensor clock are
+ * updated by a first order filter.
+ *
+ * @param[in,out] sync   : Structure instance of bma400_clock_sync.
+ * @param[in] sensortime : Sensor time, see bma400_sensortime_extend.
+ * @param[in] tick       : sl_sleeptimer_get_tick_count64 at that instant.
+ *
+ * @note Pairs must be given in time order, less than 2^32 sleeptimer
+ * ticks apart, i.e. 36.4 hours at 32768 Hz. A later pair is rejected,
+ * start over with bma400_clock_sync_init.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_clock_sync_update(struct bma400_clock_sync *sync,
+		uint64_t sensortime, uint64_t tick);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_clock_sync_sample bma400_clock_sync_sample
+ * \code
+ * int8_t bma400_clock_sync_sample(struct bma400_clock_sync *sync, struct bma400_sensortime *sensortime,
+ *                                 const struct bma400_dev *dev);
+ * \endcode
+ * @details This API reads the sensor time register and adds it to the
+ * estimate, paired with the sleeptimer tick in the middle of the read.
+ *
+ * @param[in,out] sync       : Structure instance of bma400_clock_sync.
+ * @param[in,out] sensortime : 64 bit sensor time clock, shared with the
+ *                             FIFO timestamps.
+ * @param[in] dev            : Structure instance of bma400_dev.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_clock_sync_sample(struct bma400_clock_sync *sync,
+		struct bma400_sensortime *sensortime, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_clock_sync_to_tick bma400_clock_sync_to_tick
+ * \code
+ * int8_t bma400_clock_sync_to_tick(const struct bma400_clock_sync *sync, uint64_t sensortime, uint64_t *tick);
+ * \endcode
+ * @details This API converts a 64 bit sensor time, e.g. a FIFO timestamp,
+ * to a sleeptimer tick.
+ *
+ * @param[in] sync       : Structure instance of bma400_clock_sync.
+ * @param[in] sensortime : Sensor time.
+ * @param[out] tick      : Sleeptimer tick.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_NO_DATA before the first pair)
+ * @retval Negative Error
+ */
+int8_t bma400_clock_sync_to_tick(const struct bma400_clock_sync *sync,
+		uint64_t sensortime, uint64_t *tick);
+
+#if SL_SLEEPTIMER_WALLCLOCK_CONFIG
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_clock_sync_to_time bma400_clock_sync_to_time
+ * \code
+ * int8_t bma400_clock_sync_to_time(const struct bma400_clock_sync *sync, uint64_t sensortime,
+ *                                  sl_sleeptimer_timestamp_t *time);
+ * \endcode
+ * @details This API converts a 64 bit sensor time to the epoch time of
+ * sl_sleeptimer_get_time, rounded to the second. It is only available
+ * when SL_SLEEPTIMER_WALLCLOCK_CONFIG is enabled.
+ *
+ * @param[in] sync       : Structure instance of bma400_clock_sync.
+ * @param[in] sensortime : Sensor time.
+ * @param[out] time      : Epoch time in seconds.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_NO_DATA before the first pair)
+ * @retval Negative Error
+ */
+int8_t bma400_clock_sync_to_time(const struct bma400_clock_sync *sync,
+		uint64_t sensortime, sl_sleeptimer_timestamp_t *time);
+#endif
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_set_fifo_compact bma400_set_fifo_compact
+ * \code
+ * int8_t bma400_set_fifo_compact(uint8_t enable, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API switches the FIFO between 12 bit and compact 8 bit
+ * frames. An XYZ frame takes 4 bytes instead of 7, so the FIFO holds 256
+ * frames instead of 146. The watermark keeps its level in bytes, aligned to
+ * whole frames, so each watermark interrupt carries more frames.
+ *
+ * @param[in] enable    : BMA400_ENABLE for 8 bit frames, BMA400_DISABLE for
+ *                        12 bit frames.
+ * @param[in] dev       : Structure instance of bma400_dev.
+ *
+ * @note 8 bit frames are extracted scaled like 12 bit data, the 4 LSBs
+ * being 0. The FIFO should be flushed after the switch.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_set_fifo_compact(uint8_t enable, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_fifo_stream_reset bma400_fifo_stream_reset
+ * \code
+ * int8_t bma400_fifo_stream_reset(struct bma400_fifo_stream *stream);
+ * \endcode
+ * @details This API clears the split frame kept by a FIFO stream context.
+ * It must be called before the first read and after the FIFO is flushed.
+ *
+ * @param[in,out] stream : Structure instance of bma400_fifo_stream.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_fifo_stream_reset(struct bma400_fifo_stream *stream);
+
+/*!
+ * \ingroup bma400ApiFifo
+ * \page bma400_api_bma400_extract_accel_stream bma400_extract_accel_stream
+ * \code
+ * int8_t bma400_extract_accel_stream(struct bma400_fifo_stream *stream, struct bma400_fifo_data *fifo,
+ *                                    struct bma400_sensor_data *accel_data, uint16_t *frame_count,
+ *                                    const struct bma400_dev *dev);
+ * \endcode
+ * @details This API parses FIFO data like "bma400_extract_accel", for FIFO
+ * contents read in several chunks. A frame cut by the end of a chunk is
+ * kept in the stream context and completed from the start of the next
+ * chunk, so no frame is lost at chunk boundaries.
+ *
+ * @param[in,out] stream      : Structure instance of bma400_fifo_stream.
+ * @param[in,out] fifo        : Pointer to the FIFO structure.
+ * @param[out] accel_data     : Structure instance of bma400_sensor_data where
+ *                              the accelerometer data from FIFO is stored.
+ * @param[in,out] frame_count : Number of valid accelerometer frames requested
+ *                              by user is given as input and it is updated by
+ *                              the actual frames parsed from the FIFO
+ * @param[in] dev             : Structure instance of bma400_dev.
+ *
+ * @note The chunk must be read without overread, i.e. with fifo->length not
+ * exceeding the FIFO fill level, so that it ends on FIFO data.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_extract_accel_stream(struct bma400_fifo_stream *stream,
+		struct bma400_fifo_data *fifo, struct bma400_sensor_data *accel_data,
+		uint16_t *frame_count, const struct bma400_dev *dev);
+
+/**
+ * \ingroup bma400
+ * \defgroup bma400ApiInterrupt Interrupt
+ * @brief Interrupt API
+ */
+
+/*!
+ * \ingroup bma400ApiInterrupt
+ * \page bma400_api_bma400_get_interrupt_status bma400_get_interrupt_status
+ * \code
+ * int8_t bma400_get_interrupt_status(uint16_t *int_status, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API is used to check if the interrupts are asserted and return the status.
+ *
+ * @param[in] int_status   : Interrupt status of sensor
+ * @param[in] dev          : Structure instance of bma400_dev.
+ *
+ * @note Interrupt status of the sensor determines which all interrupts are asserted at any instant of time.
+ * @code
+ *  BMA400_WAKEUP_INT_ASSERTED
+ *  BMA400_ORIENT_CH_INT_ASSERTED
+ *  BMA400_GEN1_INT_ASSERTED
+ *  BMA400_GEN2_INT_ASSERTED
+ *  BMA400_FIFO_FULL_INT_ASSERTED
+ *  BMA400_FIFO_WM_INT_ASSERTED
+ *  BMA400_DRDY_INT_ASSERTED
+ *  BMA400_INT_OVERRUN_ASSERTED
+ *  BMA400_STEP_INT_ASSERTED
+ *  BMA400_S_TAP_INT_ASSERTED
  *  BMA400_D_TAP_INT_ASSERTED
  *  BMA400_ACT_CH_X_ASSERTED
  *  BMA400_ACT_CH_Y_ASSERTED
@@ -530,6 +1539,139 @@ int8_t bma400_set_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
 int8_t bma400_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint8_t len,
 		const struct bma400_dev *dev);
 
+/*!
+ * \ingroup bma400ApiRegister
+ * \page bma400_api_bma400_get_regs_inplace bma400_get_regs_inplace
+ * \code
+ * int8_t bma400_get_regs_inplace(uint8_t reg_addr, uint8_t *buffer, uint16_t len, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API reads the data from the given register address of sensor
+ * without any intermediate buffer. The address byte is sent from the start
+ * of the buffer, which then receives the data in place.
+ *
+ * @param[in] reg_addr   : Register address from where the data to be read
+ * @param[in,out] buffer : Buffer of len + BMA400_READ_HEADROOM bytes. The data
+ *                         starts at buffer[1 + dev->dummy_byte].
+ * @param[in] len        : No of bytes of data to be read.
+ * @param[in] dev        : Structure instance of bma400_dev.
+ *
+ * @note The register shadow is refreshed from the data read, but never used
+ * to serve this API.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_get_regs_inplace(uint8_t reg_addr, uint8_t *buffer, uint16_t len,
+		const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiRegister
+ * \page bma400_api_bma400_batch_add_regs bma400_batch_add_regs
+ * \code
+ * int8_t bma400_batch_add_regs(uint8_t reg_addr, const uint8_t *reg_data, uint8_t len, struct bma400_reg_batch *batch);
+ * \endcode
+ * @details This API queues consecutive register writes in a register batch.
+ * Registers of different blocks may be queued in the same batch, as every
+ * register is stored as its own address/data pair.
+ *
+ * @param[in] reg_addr  : Register address of the first byte to be written.
+ * @param[in] reg_data  : Pointer to data buffer which is to be queued.
+ * @param[in] len       : No of bytes of data to queue.
+ * @param[in,out] batch : Register batch, zero-initialized before first use.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error (BMA400_E_INVALID_CONFIG if the batch is full)
+ */
+int8_t bma400_batch_add_regs(uint8_t reg_addr, const uint8_t *reg_data,
+		uint8_t len, struct bma400_reg_batch *batch);
+
+/*!
+ * \ingroup bma400ApiRegister
+ * \page bma400_api_bma400_batch_write bma400_batch_write
+ * \code
+ * int8_t bma400_batch_write(struct bma400_reg_batch *batch, uint16_t *saved_xfers, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API writes all the registers queued in the batch within a
+ * single SPI transaction and empties the batch on success.
+ *
+ * @param[in,out] batch    : Register batch to be written.
+ * @param[out] saved_xfers : Number of bus transactions saved compared to
+ *                           writing each register on its own. May be NULL.
+ * @param[in] dev          : Structure instance of bma400_dev.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_batch_write(struct bma400_reg_batch *batch,
+		uint16_t *saved_xfers, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiRegister
+ * \page bma400_api_bma400_shadow_invalidate bma400_shadow_invalidate
+ * \code
+ * int8_t bma400_shadow_invalidate(const struct bma400_dev *dev);
+ * \endcode
+ * @details This API drops all the values held in the register shadow of the
+ * device, so that the next access of each register goes to the sensor.
+ * It is called by bma400_soft_reset and has no effect when dev->shadow is NULL.
+ *
+ * @param[in] dev : Structure instance of bma400_dev.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_shadow_invalidate(const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiRegister
+ * \page bma400_api_bma400_shadow_sync bma400_shadow_sync
+ * \code
+ * int8_t bma400_shadow_sync(const struct bma400_dev *dev);
+ * \endcode
+ * @details This API reloads the whole register shadow from the sensor in one
+ * burst read.
+ *
+ * @param[in] dev : Structure instance of bma400_dev.
+ *
+ * @note With a shadow attached, register reads of the range
+ * BMA400_SHADOW_START_ADDR to BMA400_SHADOW_END_ADDR are served from the
+ * shadow once known, and writes update it. Defining BMA400_SHADOW_DEBUG
+ * makes every read go to the sensor and count the differences found in
+ * dev->shadow->mismatch_cnt.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_shadow_sync(const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiRegister
+ * \page bma400_api_bma400_shadow_verify bma400_shadow_verify
+ * \code
+ * int8_t bma400_shadow_verify(const struct bma400_dev *dev);
+ * \endcode
+ * @details This API reads the shadowed register range from the sensor and
+ * compares it against the valid shadowed values, without modifying them.
+ *
+ * @param[in] dev : Structure instance of bma400_dev.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_SHADOW_MISMATCH if values differ)
+ * @retval Negative Error
+ */
+int8_t bma400_shadow_verify(const struct bma400_dev *dev);
+
 /**
  * \ingroup bma400
  * \defgroup bma400ApiSystem System
@@ -563,8 +1705,9 @@ int8_t bma400_soft_reset(const struct bma400_dev *dev);
  * @param[in] dev    : Structure instance of bma400_dev.
  *
  * @note The return value of this API is the result of self test.
- * A self test does not soft reset of the sensor. Hence, the user can
- * define the required settings after performing the self test.
+ * The sensor is soft reset afterwards, so the user defines the required
+ * settings after performing the self test. It blocks for about 110ms,
+ * bma400_self_test_start runs it in the background and keeps the settings.
  *
  * @return Result of API execution status.
  * @retval Zero Success
@@ -572,6 +1715,185 @@ int8_t bma400_soft_reset(const struct bma400_dev *dev);
  * @retval Negative Error / failure
  */
 int8_t bma400_perform_self_test(const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_self_test_start bma400_self_test_start
+ * \code
+ * int8_t bma400_self_test_start(struct bma400_self_test *st, bma400_bringup_cb_t notify, void *cb_ctx,
+ *                               const struct bma400_dev *dev);
+ * \endcode
+ * @details This API starts the self test without blocking. The accel
+ * configuration is saved and set for the test, and the enable delay and
+ * both excitation periods run on a sleeptimer. The application calls
+ * bma400_self_test_process whenever notified, or from its main loop, and
+ * keeps serving other events meanwhile.
+ *
+ * @param[in,out] st    : Structure instance of bma400_self_test,
+ *                        zero-initialized before first use.
+ * @param[in] notify    : Called from the sleeptimer interrupt when a step
+ *                        is due, may be NULL.
+ * @param[in] cb_ctx    : User context passed to notify.
+ * @param[in] dev       : Structure instance of bma400_dev.
+ *
+ * @note At the end, pass or fail, ACCEL_CONFIG0 to ACCEL_CONFIG2 are
+ * written back as they were, the power mode included, instead of a soft
+ * reset. All other settings are left untouched. A switch back to low power
+ * mode takes up to 1/ODR.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_IN_PROGRESS once started)
+ * @retval Negative Error (BMA400_E_BUSY while a self test is running)
+ */
+int8_t bma400_self_test_start(struct bma400_self_test *st,
+		bma400_bringup_cb_t notify, void *cb_ctx, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_self_test_process bma400_self_test_process
+ * \code
+ * int8_t bma400_self_test_process(struct bma400_self_test *st);
+ * \endcode
+ * @details This API runs the due step of an asynchronous self test. Once
+ * it ends, st->result holds the positive minus negative excitation of each
+ * axis in mg and the axes below their limit. The limits are compared with
+ * the exact excursion, not the one rounded to mg.
+ *
+ * @param[in,out] st   : Structure instance of bma400_self_test.
+ *
+ * @code
+ *  bma400_self_test_start(&st, NULL, NULL, &bma);
+ *  do {
+ *      ... BLE events ...
+ *      rslt = bma400_self_test_process(&st);
+ *  } while (rslt == BMA400_W_IN_PROGRESS);
+ * @endcode
+ *
+ * @return Result of API execution status
+ * @retval Zero Success, self test passed or none running
+ * @retval Postive Warning (BMA400_W_IN_PROGRESS while running,
+ *                  BMA400_W_SELF_TEST_FAIL when an axis failed)
+ * @retval Negative Error
+ */
+int8_t bma400_self_test_process(struct bma400_self_test *st);
+
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_self_test_abort bma400_self_test_abort
+ * \code
+ * int8_t bma400_self_test_abort(struct bma400_self_test *st);
+ * \endcode
+ * @details This API stops a running asynchronous self test and restores
+ * the accel configuration. st->result is left from the previous test.
+ *
+ * @param[in,out] st   : Structure instance of bma400_self_test.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error
+ */
+int8_t bma400_self_test_abort(struct bma400_self_test *st);
+
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_calib_capture bma400_calib_capture
+ * \code
+ * int8_t bma400_calib_capture(uint8_t orientation, uint8_t n_samples,
+ *                             struct bma400_calib_session *session, const struct bma400_dev *dev);
+ * \endcode
+ * @details This API captures the board held still in one orientation for
+ * the offset and gain calibration. n_samples readings of
+ * bma400_get_accel_data are taken one output data period apart and the
+ * mean of the vertical axis is kept in the session.
+ *
+ * @param[in] orientation   : BMA400_CALIB_X_UP to BMA400_CALIB_Z_DOWN,
+ *                            the named axis pointing up or down.
+ * @param[in] n_samples     : Number of readings averaged.
+ * @param[in,out] session   : Structure instance of bma400_calib_session,
+ *                            zero initialised before the first capture.
+ * @param[in] dev           : Structure instance of bma400_dev.
+ *
+ * @note The capture blocks for n_samples output data periods. All the
+ * captures of a session take the range set at the first one.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_CALIB_REJECTED when the board moved
+ *                  or the axis is not within 60 degrees of vertical)
+ * @retval Negative Error
+ */
+int8_t bma400_calib_capture(uint8_t orientation, uint8_t n_samples,
+		struct bma400_calib_session *session, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_calib_solve bma400_calib_solve
+ * \code
+ * int8_t bma400_calib_solve(const struct bma400_calib_session *session, struct bma400_calib *calib);
+ * \endcode
+ * @details This API solves the offset and gain of each axis from the six
+ * captures of a session. The offset is midway between the axis pointing up
+ * and down, the gain maps the span between them on 2 g.
+ *
+ * @param[in] session   : Structure instance of bma400_calib_session.
+ * @param[out] calib    : Structure instance of bma400_calib, ready to be
+ *                        stored as is.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Postive Warning (BMA400_W_CALIB_REJECTED when a gain is more
+ *                  than 12.5 % or an offset more than 250 mg off)
+ * @retval Negative Error (BMA400_E_INVALID_CONFIG until all six are
+ *                  captured)
+ */
+int8_t bma400_calib_solve(const struct bma400_calib_session *session,
+		struct bma400_calib *calib);
+
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_calib_check bma400_calib_check
+ * \code
+ * int8_t bma400_calib_check(const struct bma400_calib *calib);
+ * \endcode
+ * @details This API checks a calibration record read back from storage:
+ * its version, its check and the plausibility of the coefficients.
+ *
+ * @param[in] calib   : Structure instance of bma400_calib.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error (BMA400_E_INVALID_CONFIG for a blank, corrupt
+ *                  or outdated record)
+ */
+int8_t bma400_calib_check(const struct bma400_calib *calib);
+
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_set_calib bma400_set_calib
+ * \code
+ * int8_t bma400_set_calib(const struct bma400_calib *calib, struct bma400_dev *dev);
+ * \endcode
+ * @details This API sets the calibration applied by the FIFO extraction
+ * APIs. Each value is corrected by a fixed-point multiply-add as it is
+ * unpacked, with no further pass over the data. NULL goes back to the raw
+ * data.
+ *
+ * @param[in] calib   : Structure instance of bma400_calib, referenced
+ *                      until replaced. May be NULL.
+ * @param[in,out] dev : Structure instance of bma400_dev.
+ *
+ * @note The coefficients hold at the range they were solved at only. Set
+ * the calibration again, or NULL, after a range change. Data from
+ * bma400_get_accel_data stays raw.
+ *
+ * @return Result of API execution status
+ * @retval Zero Success
+ * @retval Negative Error (BMA400_E_INVALID_CONFIG for a record failing
+ *                  bma400_calib_check or solved at another range)
+ */
+int8_t bma400_set_calib(const struct bma400_calib *calib,
+		struct bma400_dev *dev);
 /*!
  * \ingroup bma400ApiSystem
  * \page bma400_api_bma400_get_temperature_data bma400_get_temperature_data
@@ -595,6 +1917,68 @@ int8_t bma400_perform_self_test(const struct bma400_dev *dev);
 int8_t bma400_get_temperature_data(int16_t *temperature_data,
 		const struct bma400_dev *dev);
 
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_get_status_snapshot bma400_get_status_snapshot
+ * \code
+ * int8_t bma400_get_status_snapshot(struct bma400_status_snapshot *snap, uint8_t read_steps,
+ *                                   const struct bma400_dev *dev);
+ * \endcode
+ * @details This API reads the STATUS to FIFO_LENGTH1 registers in a single
+ * burst and decodes the interrupt status, power mode, data ready and power
+ * on reset flags, latest accel sample with its sensor time, temperature and
+ * FIFO fill level. It replaces separate calls of bma400_get_interrupt_status,
+ * bma400_get_power_mode, bma400_get_accel_data, bma400_get_temperature_data
+ * and the FIFO length read when servicing an interrupt.
+ *
+ * @param[out] snap       : Structure instance of bma400_status_snapshot.
+ * @param[in] read_steps  : BMA400_ENABLE to also read the step counter.
+ * @param[in] dev         : Structure instance of bma400_dev.
+ *
+ * @note The step counter registers follow the FIFO data register, which
+ * traps the burst address, so they take a second burst. It can be limited
+ * to the snapshots where BMA400_STEP_INT_ASSERTED is set.
+ *
+ * @note As with bma400_get_interrupt_status, reading the interrupt status
+ * clears it.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_get_status_snapshot(struct bma400_status_snapshot *snap,
+		uint8_t read_steps, const struct bma400_dev *dev);
+
+/*!
+ * \ingroup bma400ApiSystem
+ * \page bma400_api_bma400_trace_drain bma400_trace_drain
+ * \code
+ * int8_t bma400_trace_drain(bma400_trace_write_t write, void *ctx, uint16_t *n_recs);
+ * \endcode
+ * @details This API passes the records of the trace ring to write, one
+ * struct bma400_trace_rec at a time, oldest first. Register accesses,
+ * queued transactions and print_rslt() only add binary records to the
+ * ring, from any context and without locking, so the tracing can stay
+ * enabled without disturbing the bus timing. bma400_trace.py decodes the
+ * output on the host.
+ *
+ * @param[in] write     : Output function, e.g. to an SWO stimulus port.
+ * @param[in] ctx       : User context passed to write.
+ * @param[out] n_recs   : Number of records written.
+ *
+ * @note To be called from the application loop when idle. Records added
+ * while the ring is full are dropped and reported by a
+ * BMA400_TRACE_DROPPED record.
+ *
+ * @return Result of API execution status.
+ * @retval Zero Success
+ * @retval Postive Warning
+ * @retval Negative Error
+ */
+int8_t bma400_trace_drain(bma400_trace_write_t write, void *ctx,
+		uint16_t *n_recs);
+
 /**
  * \ingroup bma400
  * \defgroup bma400ApiSc Step counter
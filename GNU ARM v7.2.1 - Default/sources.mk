@@ -23,6 +23,7 @@ hardware/kit/common/drivers \
 platform/Device/SiliconLabs/EFR32MG12P/Source/GCC \
 platform/Device/SiliconLabs/EFR32MG12P/Source \
 platform/emdrv/dmadrv/src \
+platform/emdrv/gpiointerrupt/src \
 platform/emdrv/sleep/src \
 platform/emdrv/spidrv/src \
 platform/emlib/src \
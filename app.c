@@ -26,6 +26,9 @@
 
 #include "app.h"
 
+#include <string.h>
+#include <bma400.h>
+
 /* Print boot message */
 static void bootMessage(struct gecko_msg_system_boot_evt_t *bootevt);
 
@@ -145,3 +148,36 @@ static void bootMessage(struct gecko_msg_system_boot_evt_t *bootevt)
   printLog("%2.2x\r\n", local_addr.addr[0]);
 #endif
 }
+
+/* Load the BMA400 calibration stored by appCalibSave */
+int8_t appCalibLoad(struct bma400_calib *calib)
+{
+  struct gecko_msg_flash_ps_load_rsp_t *rsp;
+  int8_t rslt = BMA400_E_INVALID_CONFIG;
+
+  rsp = gecko_cmd_flash_ps_load(CALIB_PS_KEY);
+
+  /* No key, a record of another layout or a bad check leave the data raw */
+  if ((rsp->result == bg_err_success) && (rsp->value.len == sizeof(*calib))) {
+    memcpy(calib, rsp->value.data, sizeof(*calib));
+    rslt = bma400_calib_check(calib);
+  }
+
+  return rslt;
+}
+
+/* Store a BMA400 calibration from bma400_calib_solve for the next boots */
+int8_t appCalibSave(const struct bma400_calib *calib)
+{
+  int8_t rslt;
+
+  rslt = bma400_calib_check(calib);
+  if ((rslt == BMA400_OK)
+      && (gecko_cmd_flash_ps_save(CALIB_PS_KEY, sizeof(*calib),
+                                  (const uint8 *) calib)->result != bg_err_success)) {
+    printLog("calibration not stored\r\n");
+    rslt = BMA400_E_COM_FAIL;
+  }
+
+  return rslt;
+}
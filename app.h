@@ -17,6 +17,7 @@
 #ifndef APP_H_
 #define APP_H_
 
+#include <stdint.h>
 #include "gecko_configuration.h"
 
 /* DEBUG_LEVEL is used to enable/disable debug prints. Set DEBUG_LEVEL to 1 to enable debug prints */
@@ -43,4 +44,13 @@
 /* Main application */
 void appMain(gecko_configuration_t *pconfig);
 
+/* PS key of the BMA400 calibration, in the user range 0x4000 to 0x407F */
+#define CALIB_PS_KEY 0x4000
+
+struct bma400_calib;
+
+/* Load and store the BMA400 calibration. The stack must have booted. */
+int8_t appCalibLoad(struct bma400_calib *calib);
+int8_t appCalibSave(const struct bma400_calib *calib);
+
 #endif
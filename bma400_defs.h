@@ -47,6 +47,8 @@
 #else
 #include <stdint.h>
 #include <stddef.h>
+#include "sl_sleeptimer.h"
+#include "spidrv.h"
 #endif
 
 #if !defined(UINT8_C) && !defined(INT8_C)
@@ -86,7 +88,9 @@
 #define FALSE                          UINT8_C(0)
 #endif
 
-/* API success code */
+/* API success code. The result codes are also decoded by the RSLT table
+ * of bma400_trace.py
+ */
 #define BMA400_OK                      INT8_C(0)
 
 /* API error codes */
@@ -94,9 +98,14 @@
 #define BMA400_E_COM_FAIL              INT8_C(-2)
 #define BMA400_E_DEV_NOT_FOUND         INT8_C(-3)
 #define BMA400_E_INVALID_CONFIG        INT8_C(-4)
+#define BMA400_E_BUSY                  INT8_C(-5)
 
 /* API warning codes */
 #define BMA400_W_SELF_TEST_FAIL        INT8_C(1)
+#define BMA400_W_SHADOW_MISMATCH       INT8_C(2)
+#define BMA400_W_NO_DATA               INT8_C(3)
+#define BMA400_W_IN_PROGRESS           INT8_C(4)
+#define BMA400_W_CALIB_REJECTED        INT8_C(5)
 
 /* CHIP ID VALUE */
 #define BMA400_CHIP_ID                 UINT8_C(0x90)
@@ -127,12 +136,28 @@
 #define BMA400_ODR_400HZ               UINT8_C(0x0A)
 #define BMA400_ODR_800HZ               UINT8_C(0x0B)
 
+/* Sensor time: 24 bit counter at 25.6 kHz (39.0625 us), the number of
+ * ticks per sample is 1 << (BMA400_SENSORTIME_ODR_SHIFT - odr)
+ */
+#define BMA400_SENSORTIME_MASK         UINT32_C(0xFFFFFF)
+#define BMA400_SENSORTIME_ODR_SHIFT    UINT8_C(16)
+
+/* Sensor time ticks per second */
+#define BMA400_SENSORTIME_FREQ_HZ      UINT32_C(25600)
+
+/* Conversion of sensor time ticks to micro seconds */
+#define BMA400_SENSORTIME_TO_US(ticks) (((uint64_t)(ticks) * 625) / 16)
+
 /* Accel Range configuration */
 #define BMA400_2G_RANGE                UINT8_C(0x00)
 #define BMA400_4G_RANGE                UINT8_C(0x01)
 #define BMA400_8G_RANGE                UINT8_C(0x02)
 #define BMA400_16G_RANGE               UINT8_C(0x03)
 
+/* Accel data resolution, used by the unit conversion kernels */
+#define BMA400_8_BIT_RESOLUTION        UINT8_C(8)
+#define BMA400_12_BIT_RESOLUTION       UINT8_C(12)
+
 /* Accel Axes selection settings for
  * DATA SAMPLING, WAKEUP, ORIENTATION CHANGE,
  * GEN1, GEN2 , ACTIVITY CHANGE
@@ -337,7 +362,9 @@
 #define BMA400_CHIP_ID_ADDR              UINT8_C(0x00)
 #define BMA400_STATUS_ADDR               UINT8_C(0x03)
 #define BMA400_ACCEL_DATA_ADDR           UINT8_C(0x04)
+#define BMA400_SENSOR_TIME_ADDR          UINT8_C(0x0A)
 #define BMA400_INT_STAT0_ADDR            UINT8_C(0x0E)
+#define BMA400_EVENT_ADDR                UINT8_C(0x0D)
 #define BMA400_TEMP_DATA_ADDR            UINT8_C(0x11)
 #define BMA400_FIFO_LENGTH_ADDR          UINT8_C(0x12)
 #define BMA400_FIFO_DATA_ADDR            UINT8_C(0x14)
@@ -372,10 +399,149 @@
 #define BMA400_SELF_TEST_DELAY_MS        UINT8_C(7)
 #define BMA400_SELF_TEST_DATA_READ_MS    UINT8_C(50)
 
+/* Upper bounds of the bring-up waits, the asynchronous bring-up polls the
+ * sensor every BMA400_BRINGUP_POLL_MS and finishes as soon as it is ready
+ */
+#define BMA400_POWER_UP_TIMEOUT_MS       UINT8_C(5)
+#define BMA400_SOFT_RESET_TIMEOUT_MS     UINT8_C(10)
+#define BMA400_POWER_SWITCH_TIMEOUT_MS   UINT8_C(10)
+#define BMA400_LP_SWITCH_TIMEOUT_MS      UINT8_C(40)
+#define BMA400_BRINGUP_POLL_MS           UINT8_C(1)
+
+/* Asynchronous bring-up states */
+#define BMA400_BRINGUP_IDLE              UINT8_C(0)
+#define BMA400_BRINGUP_POWER_UP          UINT8_C(1)
+#define BMA400_BRINGUP_SOFT_RESET        UINT8_C(2)
+#define BMA400_BRINGUP_POWER_MODE        UINT8_C(3)
+
+/* Asynchronous self-test states */
+#define BMA400_SELF_TEST_IDLE            UINT8_C(0)
+#define BMA400_SELF_TEST_SETTLE          UINT8_C(1)
+#define BMA400_SELF_TEST_POSITIVE        UINT8_C(2)
+#define BMA400_SELF_TEST_NEGATIVE        UINT8_C(3)
+
+/* Self-test enable delay, the switch to normal mode included */
+#define BMA400_SELF_TEST_ENABLE_MS       UINT8_C(10)
+
+/* Self-test axes below their limit */
+#define BMA400_SELF_TEST_X_FAIL          UINT8_C(0x01)
+#define BMA400_SELF_TEST_Y_FAIL          UINT8_C(0x02)
+#define BMA400_SELF_TEST_Z_FAIL          UINT8_C(0x04)
+
+/* Calibration orientations, the named axis pointing up reads +1 g */
+#define BMA400_CALIB_X_UP                UINT8_C(0)
+#define BMA400_CALIB_X_DOWN              UINT8_C(1)
+#define BMA400_CALIB_Y_UP                UINT8_C(2)
+#define BMA400_CALIB_Y_DOWN              UINT8_C(3)
+#define BMA400_CALIB_Z_UP                UINT8_C(4)
+#define BMA400_CALIB_Z_DOWN              UINT8_C(5)
+#define BMA400_CALIB_ALL_CAPTURED        UINT8_C(0x3F)
+
+/* Layout version of struct bma400_calib, changed with the layout */
+#define BMA400_CALIB_VERSION             UINT8_C(1)
+
+/* Calibrated value = (raw * mult + add) >> BMA400_CALIB_SHIFT */
+#define BMA400_CALIB_SHIFT               UINT8_C(18)
+
+/* Unity gain in Q14 and the accepted gain error, 12.5 % */
+#define BMA400_CALIB_GAIN_ONE            UINT16_C(16384)
+#define BMA400_CALIB_GAIN_TOL            UINT16_C(2048)
+
+/* Accepted offset and accepted spread of a static capture */
+#define BMA400_CALIB_MAX_OFFSET_MG       UINT16_C(250)
+#define BMA400_CALIB_MAX_SPREAD_MG       UINT16_C(60)
+
+/* Highest SPI bit rate of the sensor */
+#define BMA400_SPI_MAX_BIT_RATE          UINT32_C(10000000)
+
+/* SPI transaction priorities, the bus queue serves the highest first and
+ * transactions of equal priority in submission order
+ */
+#define BMA400_SPI_PRIO_BULK             UINT8_C(0)
+#define BMA400_SPI_PRIO_NORMAL           UINT8_C(1)
+#define BMA400_SPI_PRIO_URGENT           UINT8_C(2)
+
+/* Segments of a scatter-gather transaction, and the LDMA SYNC bit pacing
+ * its TX chain on the RX chain
+ */
+#define BMA400_SPI_SG_MAX_SEGS           UINT8_C(4)
+#define BMA400_SPI_SG_SYNC_MSK           UINT8_C(0x80)
+
+/* Autonomous polling frame: address and dummy bytes, then the
+ * acceleration and sensor time registers read in one burst
+ */
+#define BMA400_DMA_POLL_FRAME_LEN        UINT8_C(11)
+
+/* Largest number of samples per wakeup of the autonomous polling, whose
+ * ring holds two batches
+ */
+#ifndef BMA400_DMA_POLL_MAX_BATCH
+#define BMA400_DMA_POLL_MAX_BATCH        UINT8_C(8)
+#endif
+
+/* LDMA SYNC bit set on each data ready edge and cleared once the read
+ * command is being clocked out
+ */
+#define BMA400_DMA_POLL_SYNC_MSK         UINT8_C(0x40)
+
 /* Interface selection macro */
 #define BMA400_SPI_WR_MASK               UINT8_C(0x7F)
 #define BMA400_SPI_RD_MASK               UINT8_C(0x80)
 
+/* Longest register read served through a bounded bus buffer, and the
+ * headroom for the address and dummy bytes of an in-place read
+ */
+#define BMA400_REG_READ_MAX_LEN          UINT8_C(128)
+#define BMA400_READ_HEADROOM             UINT8_C(2)
+
+/* Status snapshot burst, STATUS to FIFO_LENGTH1, stopping in front of
+ * the FIFO data register that traps the address
+ */
+#define BMA400_STATUS_BLOCK_LEN          UINT8_C(17)
+
+/* Register batch write configurations */
+#define BMA400_REG_BATCH_MAX_REGS        UINT8_C(32)
+
+/* Number of records of the trace ring, a power of two */
+#ifndef BMA400_TRACE_LEN
+#define BMA400_TRACE_LEN                 UINT16_C(64)
+#endif
+
+/* Trace events, the arguments of each are listed as arg8, arg16, arg32 */
+#define BMA400_TRACE_NONE                UINT8_C(0)
+
+/* Register read: address byte, length, duration in core clock cycles */
+#define BMA400_TRACE_SPI_READ            UINT8_C(1)
+
+/* Register write: address byte, length, duration in core clock cycles */
+#define BMA400_TRACE_SPI_WRITE           UINT8_C(2)
+
+/* Failed register access: address byte, length, result */
+#define BMA400_TRACE_SPI_ERROR           UINT8_C(3)
+
+/* Queued transaction completed: result, length, priority */
+#define BMA400_TRACE_SPI_QUEUED          UINT8_C(4)
+
+/* Result reported with print_rslt(): result, 0, 0 */
+#define BMA400_TRACE_RSLT                UINT8_C(5)
+
+/* Records lost while the ring was full: 0, 0, count */
+#define BMA400_TRACE_DROPPED             UINT8_C(6)
+
+/* Register shadow configurations, covering the writable register space */
+#define BMA400_SHADOW_START_ADDR         UINT8_C(0x19)
+#define BMA400_SHADOW_END_ADDR           UINT8_C(0x7D)
+#define BMA400_SHADOW_LEN                UINT8_C(101)
+
+/* Configuration image, covering the registers from ACCEL_CONFIG_0 to
+ * TAP_CONFIG1
+ */
+#define BMA400_CONF_IMAGE_START_ADDR     UINT8_C(0x19)
+#define BMA400_CONF_IMAGE_LEN            UINT8_C(64)
+#define BMA400_CONF_IMAGE_RESET_CONFIG_1 UINT8_C(0x49)
+#define BMA400_CONF_IMAGE_RESET_IO_CTRL  UINT8_C(0x22)
+#define BMA400_CONF_IMAGE_RESET_TAP_1    UINT8_C(0x06)
+
 /* UTILITY MACROS */
 #define BMA400_SET_LOW_BYTE              UINT16_C(0x00FF)
 #define BMA400_SET_HIGH_BYTE             UINT16_C(0xFF00)
@@ -420,7 +586,29 @@
 /* BMA400 FIFO data masks */
 #define BMA400_FIFO_HEADER_MASK          UINT8_C(0x3E)
 #define BMA400_FIFO_BYTES_OVERREAD       UINT8_C(25)
+
+/* FIFO size in bytes */
+#define BMA400_FIFO_BYTES_MAX            UINT16_C(1024)
+
+/* Address byte kept in front of the data of a FIFO read, the dummy byte
+ * follows it
+ */
+#define BMA400_FIFO_HEADROOM             UINT8_C(1)
 #define BMA400_AWIDTH_MASK               UINT8_C(0xEF)
+
+/* Header and length of 12 bit and 8 bit XYZ frames, decoded by the fast
+ * path
+ */
+#define BMA400_FIFO_XYZ_12BIT_HEADER     UINT8_C(0x9E)
+#define BMA400_FIFO_XYZ_12BIT_FRAME_LEN  UINT8_C(7)
+#define BMA400_FIFO_XYZ_8BIT_HEADER      UINT8_C(0x8E)
+#define BMA400_FIFO_XYZ_8BIT_FRAME_LEN   UINT8_C(4)
+
+/* Number of GPIO external interrupts of the MCU */
+#define BMA400_GPIO_INT_COUNT            UINT8_C(16)
+
+/* Longest FIFO frame, header included */
+#define BMA400_FIFO_MAX_FRAME_LEN        UINT8_C(7)
 #define BMA400_FIFO_DATA_EN_MASK         UINT8_C(0x0E)
 
 /* BMA400 Step status field - Activity status */
@@ -463,6 +651,11 @@
 #define BMA400_POWER_MODE_STATUS_MSK     UINT8_C(0x06)
 #define BMA400_POWER_MODE_STATUS_POS     UINT8_C(1)
 
+#define BMA400_DRDY_STAT_MSK             UINT8_C(0x80)
+#define BMA400_DRDY_STAT_POS             UINT8_C(7)
+
+#define BMA400_POR_DETECTED_MSK          UINT8_C(0x01)
+
 #define BMA400_POWER_MODE_MSK            UINT8_C(0x03)
 
 #define BMA400_ACCEL_ODR_MSK             UINT8_C(0x0F)
@@ -662,14 +855,12 @@ enum bma400_intf {
 
 /*
  * Bus communication function pointer which should be mapped to
- * the platform specific read and write functions of the user
+ * the platform specific read and write functions of the user.
+ * intf_ptr is the one of the device. The byte in front of reg_data
+ * is reserved by the driver, so that SPI transfers can run in place.
  */
-
-/*
- * typedef int8_t (*bma400_com_fptr_t)(void *intf_ptr, uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data,
- *                                    uint16_t length);
- */
-typedef int8_t (*bma400_com_fptr_t)(uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data, uint16_t length);
+typedef int8_t (*bma400_com_fptr_t)(void *intf_ptr, uint8_t dev_id, uint8_t reg_addr, uint8_t *reg_data,
+                                    uint16_t length);
 
 /* Delay function pointer */
 typedef void (*bma400_delay_fptr_t)(uint32_t period);
@@ -1257,6 +1448,93 @@ struct bma400_sensor_data
     uint32_t sensortime;
 };
 
+/*
+ * BMA400 status snapshot, read by bma400_get_status_snapshot()
+ */
+struct bma400_status_snapshot
+{
+    /* Interrupt status, see BMA400_*_INT_ASSERTED */
+    uint16_t int_status;
+
+    /* Power mode status, see BMA400_*_MODE */
+    uint8_t power_mode;
+
+    /* New accel data is available */
+    uint8_t drdy;
+
+    /* Power on reset detected since the last EVENT register read */
+    uint8_t por_detected;
+
+    /* Latest accel sample, with its sensor time */
+    struct bma400_sensor_data accel;
+
+    /* Temperature, in 0.1 degree Celsius */
+    int16_t temperature;
+
+    /* FIFO fill level in bytes */
+    uint16_t fifo_length;
+
+    /* Step count and activity, when read */
+    uint32_t step_count;
+    uint8_t activity;
+};
+
+/*
+ * BMA400 sensor time extended to a 64 bit monotonic clock
+ */
+struct bma400_sensortime
+{
+    /* Last extended sensor time */
+    uint64_t time;
+
+    /* Timestamp of the frame following the last timestamped frame */
+    uint64_t next_frame;
+
+    /* Last raw 24 bit sensor time */
+    uint32_t raw;
+
+    /* time and next_frame hold values */
+    uint8_t time_valid;
+    uint8_t next_frame_valid;
+};
+
+/*
+ * BMA400 sensor time to MCU sleeptimer clock synchronization
+ */
+struct bma400_clock_sync
+{
+    /* Reference pair of sensor time and sleeptimer tick */
+    uint64_t ref_sensortime;
+    uint64_t ref_tick;
+
+    /* Sleeptimer ticks per sensor time tick, in Q32 */
+    uint64_t rate;
+
+    /* Filter gain, as a right shift */
+    uint8_t gain_shift;
+
+    /* Number of pairs received, saturated at 255 */
+    uint8_t n_pairs;
+};
+
+/*
+ * BMA400 sensor data as separate arrays, one element per frame
+ */
+struct bma400_accel_soa
+{
+    /* X-axis sensor data */
+    int16_t *x;
+
+    /* Y-axis sensor data */
+    int16_t *y;
+
+    /* Z-axis sensor data */
+    int16_t *z;
+
+    /* sensor time, optional (NULL when not needed) */
+    uint32_t *sensortime;
+};
+
 /*
  * BMA400 interrupt selection
  */
@@ -1348,6 +1626,399 @@ struct bma400_fifo_data
 
     /* Value of FIFO sensor time time */
     uint32_t fifo_sensor_time;
+
+    /* A sensor time frame was parsed since the read, any value of
+     * fifo_sensor_time is then valid, 0 included
+     */
+    uint8_t fifo_sensor_time_avail;
+};
+
+/* FIFO read completion callback, called from interrupt context */
+typedef void (*bma400_fifo_cb_t)(int8_t rslt, struct bma400_fifo_data *fifo, void *cb_ctx);
+
+/*
+ * BMA400 continuous FIFO acquisition context
+ */
+struct bma400_fifo_acq
+{
+    /* The two buffers, filled alternately by DMA */
+    struct bma400_fifo_data fifo[2];
+
+    /* User callback for each completed buffer and its context */
+    bma400_fifo_cb_t callback;
+    void *cb_ctx;
+
+    /* Device the FIFO is read from */
+    const struct bma400_dev *dev;
+
+    /* Acquisition is running */
+    volatile uint8_t running;
+};
+
+struct bma400_spi_xfer;
+
+/* SPI transaction completion callback, called from interrupt context */
+typedef void (*bma400_spi_xfer_cb_t)(int8_t rslt, struct bma400_spi_xfer *xfer, void *cb_ctx);
+
+/*
+ * BMA400 SPI bus, one SPIDRV instance per USART shared by its devices
+ */
+struct bma400_spi_bus
+{
+    /* SPIDRV instance, with the chip selects driven by the devices.
+     * Kept first, the SPIDRV callbacks find the bus from the handle.
+     */
+    SPIDRV_HandleData_t handle;
+
+    /* Device the USART bit rate is currently set for */
+    const struct bma400_spi_dev *active;
+
+    /* Transaction owning the bus, NULL when idle */
+    struct bma400_spi_xfer *volatile current;
+
+    /* Transactions waiting for the bus, highest priority first */
+    struct bma400_spi_xfer *volatile queue;
+
+    /* LDMA descriptor chains of the scatter-gather transaction in
+     * progress: per segment, the data then a SYNC wait for TX, the data,
+     * chip select high and low and a SYNC toggle for RX
+     */
+    LDMA_Descriptor_t sg_tx_desc[2 * BMA400_SPI_SG_MAX_SEGS];
+    LDMA_Descriptor_t sg_rx_desc[4 * BMA400_SPI_SG_MAX_SEGS];
+};
+
+/*
+ * BMA400 SPI scatter-gather segment, one chip select frame
+ */
+struct bma400_spi_seg
+{
+    /* Bytes sent, NULL to send zeros */
+    const uint8_t *tx_data;
+
+    /* Bytes received, NULL to discard them. May be tx_data. */
+    uint8_t *rx_data;
+
+    /* Number of bytes, at most DMADRV_MAX_XFER_COUNT */
+    uint16_t length;
+};
+
+/*
+ * BMA400 SPI bus transaction, one chip select frame
+ */
+struct bma400_spi_xfer
+{
+    /* Device selected for the transaction */
+    const struct bma400_spi_dev *spi;
+
+    /* Bytes sent, NULL to send zeros */
+    const uint8_t *tx_data;
+
+    /* Bytes received, NULL to discard them. May be tx_data. */
+    uint8_t *rx_data;
+
+    /* Number of bytes, at most DMADRV_MAX_XFER_COUNT */
+    uint16_t length;
+
+    /* Scatter-gather segments, used instead of tx_data, rx_data and
+     * length when n_segs is not zero
+     */
+    const struct bma400_spi_seg *segs;
+    uint8_t n_segs;
+
+    /* One of BMA400_SPI_PRIO_* */
+    uint8_t priority;
+
+    /* Completion callback and its context, callback may be NULL */
+    bma400_spi_xfer_cb_t callback;
+    void *cb_ctx;
+
+    /* Next transaction in the bus queue */
+    struct bma400_spi_xfer *next;
+
+    /* Queued or in progress */
+    volatile uint8_t busy;
+};
+
+/*
+ * BMA400 SPI device, the intf_ptr of a bma400_dev on a bma400_spi_bus
+ */
+struct bma400_spi_dev
+{
+    /* Bus the device is wired to */
+    struct bma400_spi_bus *bus;
+
+    /* MCU GPIO port and pin of the chip select */
+    uint8_t cs_port;
+    uint8_t cs_pin;
+
+    /* SPI bit rate of the device */
+    uint32_t bit_rate;
+};
+
+/*
+ * BMA400 FIFO watermark interrupt acquisition context
+ */
+struct bma400_fifo_wm_acq
+{
+    /* MCU GPIO port and pin wired to the BMA400 interrupt pin */
+    uint8_t gpio_port;
+    uint8_t gpio_pin;
+
+    /* Watermark reached, set from the GPIO interrupt */
+    volatile uint8_t pending;
+};
+
+/*
+ * BMA400 autonomous polling context, one data ready triggered read per
+ * sample made by the LDMA
+ */
+struct bma400_dma_poll
+{
+    /* Ring of two batches of frames, filled by the RX chain */
+    uint8_t frames[2 * BMA400_DMA_POLL_MAX_BATCH][BMA400_DMA_POLL_FRAME_LEN];
+
+    /* Read command clocked out for each frame */
+    uint8_t cmd[BMA400_DMA_POLL_FRAME_LEN];
+
+    /* LDMA descriptor chains: chip select low and a SYNC set on each
+     * software request, a SYNC wait and clear then the command for TX, the
+     * frame and chip select high for each slot of the ring for RX
+     */
+    LDMA_Descriptor_t trig_desc[2];
+    LDMA_Descriptor_t tx_desc[3];
+    LDMA_Descriptor_t rx_desc[4 * BMA400_DMA_POLL_MAX_BATCH];
+
+    /* LDMA channel released from the data ready interrupt, allocated from
+     * DMADRV
+     */
+    unsigned int trig_ch;
+
+    /* Samples per batch */
+    uint8_t batch;
+
+    /* MCU GPIO port and pin wired to the interrupt pin */
+    uint8_t gpio_port;
+    uint8_t gpio_pin;
+
+    /* Device the samples are read from */
+    const struct bma400_dev *dev;
+
+    /* Interrupt latching found at the start, restored by the stop */
+    uint8_t latch;
+
+    /* Frames released and not received yet, each blocking EM2 */
+    volatile uint8_t in_flight;
+
+    /* Batches filled and not read yet, bit n for batch n */
+    volatile uint8_t filled;
+
+    /* Batch returned by the next read */
+    uint8_t next;
+
+    /* Batches filled again before being read */
+    volatile uint16_t overruns;
+
+    /* Polling is armed */
+    volatile uint8_t running;
+};
+
+/*
+ * BMA400 FIFO stream parser context
+ */
+struct bma400_fifo_stream
+{
+    /* Frame split between two FIFO reads, stored from carry[1] so that
+     * parsing starts at a non zero index
+     */
+    uint8_t carry[1 + BMA400_FIFO_MAX_FRAME_LEN];
+
+    /* Number of bytes in carry */
+    uint8_t carry_len;
+};
+
+/*
+ * BMA400 trace record, sent as is, little endian, by bma400_trace_drain()
+ */
+struct bma400_trace_rec
+{
+    /* Sleeptimer tick count */
+    uint32_t timestamp;
+
+    /* Event arguments, see BMA400_TRACE_* */
+    uint32_t arg32;
+    uint16_t arg16;
+    uint8_t arg8;
+
+    /* One of BMA400_TRACE_*, written last */
+    uint8_t event;
+};
+
+/* Trace output function, called from the application loop */
+typedef void (*bma400_trace_write_t)(const uint8_t *data, uint16_t len, void *ctx);
+
+/*
+ * BMA400 register batch, written as address/data pairs in a single
+ * SPI transaction
+ */
+struct bma400_reg_batch
+{
+    /* Interleaved register address and data bytes */
+    uint8_t pairs[2 * BMA400_REG_BATCH_MAX_REGS];
+
+    /* Number of registers queued in the batch */
+    uint8_t n_regs;
+};
+
+/*
+ * BMA400 boot image, the registers a configuration changes from their
+ * reset values
+ */
+struct bma400_boot_image
+{
+    /* Complete configuration from BMA400_CONF_IMAGE_START_ADDR */
+    uint8_t regs[BMA400_CONF_IMAGE_LEN];
+
+    /* Address/data pairs of the registers differing from their reset
+     * values, ACCEL_CONFIG_0 last so the power mode changes only once
+     * the sensor is configured
+     */
+    uint8_t pairs[2 * BMA400_CONF_IMAGE_LEN];
+
+    /* Number of registers in pairs */
+    uint8_t n_regs;
+};
+
+/* Bring-up notification, called from the sleeptimer interrupt when
+ * bma400_bringup_process() has work to do
+ */
+typedef void (*bma400_bringup_cb_t)(void *cb_ctx);
+
+/*
+ * BMA400 asynchronous bring-up context
+ */
+struct bma400_bringup
+{
+    /* Poll timer */
+    sl_sleeptimer_timer_handle_t timer;
+
+    /* Device being brought up */
+    struct bma400_dev *dev;
+
+    /* Optional notification and its context */
+    bma400_bringup_cb_t notify;
+    void *cb_ctx;
+
+    /* Sleeptimer tick after which the wait is given up */
+    uint32_t deadline;
+
+    /* Current operation, BMA400_BRINGUP_IDLE when none */
+    uint8_t state;
+
+    /* Power mode waited for in BMA400_BRINGUP_POWER_MODE */
+    uint8_t power_mode;
+
+    /* Poll due, set from the timer callback */
+    volatile uint8_t pending;
+};
+
+/*
+ * BMA400 self-test outcome
+ */
+struct bma400_self_test_result
+{
+    /* Positive minus negative excitation of each axis, in mg */
+    int16_t x_mg;
+    int16_t y_mg;
+    int16_t z_mg;
+
+    /* BMA400_SELF_TEST_*_FAIL bits of the axes below their limit */
+    uint8_t failed_axes;
+};
+
+/*
+ * BMA400 asynchronous self-test context, zero-initialized before first use
+ */
+struct bma400_self_test
+{
+    /* Excitation timer */
+    sl_sleeptimer_timer_handle_t timer;
+
+    /* Device under test */
+    const struct bma400_dev *dev;
+
+    /* Optional notification and its context */
+    bma400_bringup_cb_t notify;
+    void *cb_ctx;
+
+    /* ACCEL_CONFIG0 to ACCEL_CONFIG2 as found, written back at the end */
+    uint8_t saved_conf[3];
+
+    /* Sample under positive excitation */
+    struct bma400_sensor_data accel_pos;
+
+    /* Outcome of the last completed self-test */
+    struct bma400_self_test_result result;
+
+    /* Current step, BMA400_SELF_TEST_IDLE when none */
+    uint8_t state;
+
+    /* Step due, set from the timer callback */
+    volatile uint8_t pending;
+};
+
+/*
+ * BMA400 offset and gain calibration, kept as is in non-volatile storage
+ */
+struct bma400_calib
+{
+    /* BMA400_CALIB_VERSION */
+    uint8_t version;
+
+    /* Range the coefficients were solved at */
+    uint8_t range;
+
+    /* Offset of x, y and z in 12-bit LSB, Q4 */
+    int16_t offset[3];
+
+    /* Gain correction of x, y and z in Q14 */
+    uint16_t gain[3];
+
+    /* Check over the fields above, rejects a corrupt or blank record */
+    uint16_t check;
+};
+
+/*
+ * BMA400 calibration captures, zero initialised before the first one
+ */
+struct bma400_calib_session
+{
+    /* Mean of the axis pointing up or down per orientation, 12-bit LSB
+     * in Q4
+     */
+    int32_t mean[6];
+
+    /* Range of the captures */
+    uint8_t range;
+
+    /* Bit per BMA400_CALIB_* orientation captured */
+    uint8_t captured;
+};
+
+/*
+ * BMA400 write-through register shadow
+ */
+struct bma400_reg_shadow
+{
+    /* Last known values of the registers from BMA400_SHADOW_START_ADDR
+     * to BMA400_SHADOW_END_ADDR
+     */
+    uint8_t regs[BMA400_SHADOW_LEN];
+
+    /* Validity of the shadowed values, one bit per register */
+    uint8_t valid[(BMA400_SHADOW_LEN + 7) / 8];
+
+    /* Number of shadowed values found to differ from the sensor */
+    uint16_t mismatch_cnt;
 };
 
 /*
@@ -1384,6 +2055,12 @@ struct bma400_dev
 
     /* User set read/write length */
     uint16_t read_write_len;
+
+    /* Optional register shadow, NULL disables the shadowing */
+    struct bma400_reg_shadow *shadow;
+
+    /* Optional calibration of the FIFO data, NULL leaves it raw */
+    const struct bma400_calib *calib;
 };
 
 #endif /* BMA400_DEFS_H_ */
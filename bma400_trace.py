@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""Decode the BMA400 trace records written by bma400_trace_drain().
+
+The input is the raw byte stream of the SWO stimulus port the records
+were sent to, e.g. as saved by the SWO terminal of Simplicity Studio.
+Each record is a little endian struct bma400_trace_rec of 12 bytes.
+"""
+
+import argparse
+import struct
+import sys
+
+REC = struct.Struct('<IIHBB')
+
+# Result codes of bma400_defs.h, to be extended along with them
+RSLT = {
+    -1: 'Error [-1] : Null pointer',
+    -2: 'Error [-2] : Communication failure',
+    -3: 'Error [-3] : Device not found',
+    -4: 'Error [-4] : Invalid configuration',
+    -5: 'Error [-5] : Transfer in progress',
+    1: 'Warning [1] : Self test failed',
+    2: 'Warning [2] : Register shadow mismatch',
+    3: 'Warning [3] : No data available',
+    4: 'Warning [4] : Operation in progress',
+    5: 'Warning [5] : Calibration rejected',
+}
+
+
+def s8(value):
+    return value - 256 if value > 127 else value
+
+
+def rslt_text(rslt):
+    return RSLT.get(rslt, 'Error [%d] : Unknown error code' % rslt)
+
+
+def access(addr):
+    return '%s 0x%02X' % ('read' if addr & 0x80 else 'write', addr & 0x7F)
+
+
+def decode(event, arg8, arg16, arg32, cpu_hz):
+    if event == 1:
+        return 'SPI read 0x%02X, %u bytes, %.1f us' % (
+            arg8 & 0x7F, arg16, arg32 * 1e6 / cpu_hz)
+    if event == 2:
+        return 'SPI write 0x%02X, %u bytes, %.1f us' % (
+            arg8 & 0x7F, arg16, arg32 * 1e6 / cpu_hz)
+    if event == 3:
+        return 'SPI %s, %u bytes: %s' % (access(arg8), arg16,
+                                         rslt_text(s8(arg32 & 0xFF)))
+    if event == 4:
+        return 'SPI queued, priority %u, %u bytes: %s' % (
+            arg32, arg16, 'OK' if arg8 == 0 else rslt_text(s8(arg8)))
+    if event == 5:
+        return rslt_text(s8(arg8))
+    if event == 6:
+        return '%u records dropped' % arg32
+    return 'Unknown event %u (%u, %u, %u)' % (event, arg8, arg16, arg32)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('input', nargs='?', default='-',
+                        help='binary trace file, - for stdin')
+    parser.add_argument('--tick-hz', type=float, default=32768.0,
+                        help='sleeptimer frequency (default 32768)')
+    parser.add_argument('--cpu-hz', type=float, default=38.4e6,
+                        help='core clock frequency (default 38.4 MHz)')
+    args = parser.parse_args()
+
+    if args.input == '-':
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.input, 'rb') as f:
+            data = f.read()
+
+    for offset in range(0, len(data) - REC.size + 1, REC.size):
+        timestamp, arg32, arg16, arg8, event = REC.unpack_from(data, offset)
+        print('%12.6f  %s' % (timestamp / args.tick_hz,
+                              decode(event, arg8, arg16, arg32, args.cpu_hz)))
+    if len(data) % REC.size:
+        print('%u trailing bytes ignored' % (len(data) % REC.size),
+              file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
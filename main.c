@@ -55,7 +55,22 @@
 #include "spidrv.h"
 #include <bma400.h>
 
-
+/* BMA400 trace records go out on this SWO stimulus port, apart from the
+ * printf text on port 0
+ */
+#define TRACE_ITM_PORT 1
+
+static void trace_write(const uint8_t *data, uint16_t len, void *ctx) {
+	(void) ctx;
+	if ((ITM->TCR & ITM_TCR_ITMENA_Msk)
+			&& (ITM->TER & (1UL << TRACE_ITM_PORT))) {
+		while (len-- > 0) {
+			while (ITM->PORT[TRACE_ITM_PORT].u32 == 0) {
+			}
+			ITM->PORT[TRACE_ITM_PORT].u8 = *data++;
+		}
+	}
+}
 
 int main(void) {
 	/* Initialize device */
@@ -74,21 +89,44 @@ int main(void) {
 	printf("Starting\n");
 	printf("Starting\n");
 	printf("Starting\n");
-	struct bma400_dev bma = { .chip_id = 0, .dev_id = 0, .intf = BMA400_SPI_INTF,
-			.intf_ptr = NULL, .dummy_byte = 0, .read = &spi_read, .write =
-					&spi_write, .delay_ms = &delay, .resolution = 0,
-			.read_write_len = 0, };
+	/* BMA400 on the expansion header SPI: USART1 on PC6-PC8, CS on PC9 */
+	SPIDRV_Init_t spi_init = SPIDRV_MASTER_USART1;
+	spi_init.portLocationTx = _USART_ROUTELOC0_TXLOC_LOC11;
+	spi_init.portLocationRx = _USART_ROUTELOC0_RXLOC_LOC11;
+	spi_init.portLocationClk = _USART_ROUTELOC0_CLKLOC_LOC11;
+	spi_init.bitRate = BMA400_SPI_MAX_BIT_RATE;
+	static struct bma400_spi_bus spi_bus;
+	static struct bma400_spi_dev bma_spi;
+	static struct bma400_spi_dev flash_spi;
+	struct bma400_dev bma = { .chip_id = 0, .dev_id = 0, .dummy_byte = 0,
+			.resolution = 0, .read_write_len = 0, };
 	int8_t rslt;
+	uint16_t n_recs;
 
-	//set_interface(BMA400_SPI_INTF, &bma);
-
-	rslt = bma400_init(&bma);
+	ITM->TER |= 1UL << TRACE_ITM_PORT;
+	rslt = bma400_spi_bus_init(&spi_bus, &spi_init);
+	if (rslt == BMA400_OK) {
+		rslt = bma400_spi_dev_init(&bma_spi, &spi_bus, gpioPortC, 9, 0, &bma);
+	}
+	if (rslt == BMA400_OK) {
+		/* The MX25 flash shares USART1, its transfers go through
+		 * bma400_spi_submit() on flash_spi
+		 */
+		rslt = bma400_spi_dev_init(&flash_spi, &spi_bus, BSP_EXTFLASH_CS_PORT,
+				BSP_EXTFLASH_CS_PIN, HAL_EXTFLASH_FREQUENCY, NULL);
+	}
+	if (rslt == BMA400_OK) {
+		rslt = bma400_init(&bma);
+	}
 	print_rslt(rslt);
 
 	if (rslt == BMA400_OK) {
 		printf("BMA400 found with chip ID 0x%X\r\n", bma.chip_id);
 	}
 
+	/* Decoded on the host with bma400_trace.py */
+	(void) bma400_trace_drain(trace_write, NULL, &n_recs);
+
 	//while (1) {
 	//	printf("Hello from soc-empty world!\n");
 	//}